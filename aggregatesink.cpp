@@ -0,0 +1,141 @@
+#include "aggregatesink.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+static const uint32_t kSecondsPerDay = 24 * 3600;
+
+Aggregation parseAggregation(const std::string &text)
+{
+    Aggregation aggregation;
+    std::string window = text;
+    size_t colon = text.find(':');
+    if (colon != std::string::npos) {
+        window = text.substr(0, colon);
+        std::string stat = text.substr(colon + 1);
+        if (stat == "mean" || stat == "avg") {
+            aggregation.stat = AggregateStat::Mean;
+        } else if (stat == "min") {
+            aggregation.stat = AggregateStat::Min;
+        } else if (stat == "max") {
+            aggregation.stat = AggregateStat::Max;
+        } else if (stat == "last") {
+            aggregation.stat = AggregateStat::Last;
+        } else {
+            throw std::runtime_error("未知的聚合统计量（应为 mean、min、max 或 last）：" + stat);
+        }
+    }
+
+    char *end = nullptr;
+    long n = std::strtol(window.c_str(), &end, 10);
+    long unit = 1;
+    if (*end == 'm') {
+        unit = 60;
+        ++end;
+    } else if (*end == 'h') {
+        unit = 3600;
+        ++end;
+    } else if (*end == 'd') {
+        unit = kSecondsPerDay;
+        ++end;
+    } else if (*end == 's') {
+        ++end;
+    }
+    if (window.empty() || end == window.c_str() || *end != '\0' || n < 1 ||
+        n > (long)kSecondsPerDay || n * unit > (long)kSecondsPerDay ||
+        kSecondsPerDay % (n * unit) != 0) {
+        throw std::runtime_error("无效的聚合窗口（应能整除一天，如 10s、1m、15m、1h、1d）：" + text);
+    }
+    aggregation.windowSeconds = (uint32_t)(n * unit);
+    return aggregation;
+}
+
+// 时间戳所在窗口的起点：窗口整除一天，按当日秒数向下取整即可，不跨日
+static inline uint64_t windowStart(uint64_t ts, uint32_t windowSeconds)
+{
+    uint32_t second = (uint32_t)(timestampHour(ts) * 3600 + timestampMinute(ts) * 60 +
+                                 timestampSecond(ts));
+    second -= second % windowSeconds;
+    return packTimestamp(timestampYear(ts), timestampMonth(ts), timestampDay(ts),
+                         (int)(second / 3600), (int)(second / 60 % 60), (int)(second % 60));
+}
+
+AggregateSink::AggregateSink(std::unique_ptr<RecordSink> inner, const Aggregation &aggregation)
+    : m_inner(std::move(inner))
+    , m_aggregation(aggregation)
+{
+}
+
+void AggregateSink::writeHeader()
+{
+    m_inner->writeHeader();
+}
+
+void AggregateSink::writeRow(uint64_t ts, const float *values, size_t count)
+{
+    uint64_t window = windowStart(ts, m_aggregation.windowSeconds);
+    if (m_rows == 0 || window != m_window) {
+        flushWindow();
+        m_window = window;
+        m_count = count;
+        std::fill(m_sum.begin(), m_sum.end(), 0.0);
+        std::copy(values, values + count, m_min.begin());
+        std::copy(values, values + count, m_max.begin());
+    }
+    // 每行的值在内存中连续，各统计量的循环可由编译器向量化
+    switch (m_aggregation.stat) {
+    case AggregateStat::Mean:
+        for (size_t c = 0; c < count; ++c) {
+            m_sum[c] += values[c];
+        }
+        break;
+    case AggregateStat::Min:
+        for (size_t c = 0; c < count; ++c) {
+            m_min[c] = std::min(m_min[c], values[c]);
+        }
+        break;
+    case AggregateStat::Max:
+        for (size_t c = 0; c < count; ++c) {
+            m_max[c] = std::max(m_max[c], values[c]);
+        }
+        break;
+    case AggregateStat::Last:
+        break;
+    }
+    std::copy(values, values + count, m_last.begin());
+    ++m_rows;
+}
+
+void AggregateSink::flushWindow()
+{
+    if (m_rows == 0) {
+        return;
+    }
+    float values[kChannelCount];
+    switch (m_aggregation.stat) {
+    case AggregateStat::Mean:
+        for (size_t c = 0; c < m_count; ++c) {
+            values[c] = (float)(std::round(m_sum[c] / (double)m_rows * 100.0) / 100.0);
+        }
+        break;
+    case AggregateStat::Min:
+        std::copy(m_min.begin(), m_min.begin() + m_count, values);
+        break;
+    case AggregateStat::Max:
+        std::copy(m_max.begin(), m_max.begin() + m_count, values);
+        break;
+    case AggregateStat::Last:
+        std::copy(m_last.begin(), m_last.begin() + m_count, values);
+        break;
+    }
+    m_inner->writeRow(m_window, values, m_count);
+    m_rows = 0;
+}
+
+void AggregateSink::close()
+{
+    flushWindow();
+    m_inner->close();
+}
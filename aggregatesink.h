@@ -0,0 +1,67 @@
+#ifndef AGGREGATESINK_H
+#define AGGREGATESINK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "recordsink.h"
+
+/// 聚合窗口内各通道取的统计量
+enum class AggregateStat {
+    Mean,   ///< 平均值，保留两位小数（同原始数据）
+    Min,
+    Max,
+    Last,   ///< 窗口内最后一行的值
+};
+
+/// 按时间窗口聚合输出：windowSeconds 为0时不聚合
+struct Aggregation {
+    uint32_t windowSeconds = 0;
+    AggregateStat stat = AggregateStat::Mean;
+
+    bool active() const { return windowSeconds != 0; }
+};
+
+/**
+ * @brief parseAggregation
+ *  解析 "<长度>[s|m|h|d][:mean|min|max|last]"，如 "1m"、"15s:max"、"1h:last"；
+ *  省略单位为秒，省略统计量为 mean。窗口按自然时刻对齐（每分、每时、每日零点起），
+ *  长度须能整除一天。格式或取值非法时抛出 std::runtime_error。
+ */
+Aggregation parseAggregation(const std::string &text);
+
+/**
+ * @brief AggregateSink
+ *  在记录与输出端之间按时间窗口聚合：每个窗口只向 inner 写一行，时间戳为窗口起点，
+ *  各列为窗口内该通道的统计量，列与表头不变，可直接套在 CSV、Arrow 等任意输出端外。
+ *  输入按时间顺序逐行到达（RecordSink 的约定），单遍、常数内存，
+ *  多文件合并、流式与外部排序的输出同样适用。
+ */
+class AggregateSink : public RecordSink
+{
+public:
+    AggregateSink(std::unique_ptr<RecordSink> inner, const Aggregation &aggregation);
+
+    void writeHeader() override;
+    void writeRow(uint64_t ts, const float *values, size_t count) override;
+    /// 写出最后一个窗口并关闭 inner
+    void close() override;
+
+private:
+    void flushWindow();
+
+    std::unique_ptr<RecordSink> m_inner;
+    Aggregation m_aggregation;
+    uint64_t m_window = 0;          ///< 当前窗口起点（打包时间戳）
+    size_t m_rows = 0;              ///< 当前窗口已累积的行数
+    size_t m_count = 0;             ///< 每行的值个数
+    std::array<double, kChannelCount> m_sum;
+    std::array<float, kChannelCount> m_min;
+    std::array<float, kChannelCount> m_max;
+    std::array<float, kChannelCount> m_last;
+};
+
+#endif // AGGREGATESINK_H
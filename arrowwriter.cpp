@@ -0,0 +1,485 @@
+#include "arrowwriter.h"
+#include "perfstats.h"
+#include "recyclepool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+// Arrow IPC 文件格式：
+//   "ARROW1\0\0" | Schema 消息 | RecordBatch 消息... | 结束标记 | Footer | int32 Footer长度 | "ARROW1"
+// 每条消息：0xFFFFFFFF | int32 元数据长度 | FlatBuffers 编码的 Message（补齐到8字节） | 消息体
+// 数值按小端写出（本程序只面向小端平台）。
+
+static const char kArrowMagic[] = "ARROW1";
+static const int16_t kMetadataV5 = 4;
+static const char *const kTimestampName = "时间";
+
+// Message 联合体类型
+static const uint8_t kHeaderSchema = 1;
+static const uint8_t kHeaderRecordBatch = 3;
+// Type 联合体类型
+static const uint8_t kTypeFloatingPoint = 3;
+static const uint8_t kTypeTimestamp = 10;
+static const int16_t kPrecisionSingle = 1;
+static const int16_t kTimeUnitSecond = 0;
+
+static inline size_t align8(size_t n)
+{
+    return (n + 7) & ~(size_t)7;
+}
+
+namespace {
+
+/**
+ * 极简 FlatBuffers 编码器，只覆盖 Arrow 元数据用到的部分：表、字符串、
+ * 结构体数组和表数组。对象按前序依次向后写出（vtable 紧挨在表之前），
+ * 子对象写完后回填父对象中的偏移，因此所有偏移都指向后方，符合格式要求。
+ */
+class FbObject
+{
+public:
+    virtual ~FbObject() {}
+    /// 写到 buf 末尾，返回父对象偏移应指向的位置
+    virtual size_t write(std::vector<uint8_t> &buf) const = 0;
+};
+
+typedef std::shared_ptr<FbObject> FbPtr;
+
+static void padTo(std::vector<uint8_t> &buf, size_t alignment)
+{
+    while (buf.size() % alignment) {
+        buf.push_back(0);
+    }
+}
+
+template <typename T>
+static void put(std::vector<uint8_t> &buf, size_t pos, T value)
+{
+    std::memcpy(buf.data() + pos, &value, sizeof(T));
+}
+
+template <typename T>
+static void append(std::vector<uint8_t> &buf, T value)
+{
+    size_t pos = buf.size();
+    buf.resize(pos + sizeof(T));
+    put(buf, pos, value);
+}
+
+class FbString : public FbObject
+{
+public:
+    explicit FbString(std::string text) : m_text(std::move(text)) {}
+
+    size_t write(std::vector<uint8_t> &buf) const override
+    {
+        padTo(buf, 4);
+        size_t pos = buf.size();
+        append<uint32_t>(buf, (uint32_t)m_text.size());
+        buf.insert(buf.end(), m_text.begin(), m_text.end());
+        buf.push_back(0);
+        return pos;
+    }
+
+private:
+    std::string m_text;
+};
+
+/// 结构体数组：元素为已按小端排好的定长字节，按 8 字节对齐
+class FbStructVector : public FbObject
+{
+public:
+    FbStructVector(size_t count, std::vector<uint8_t> bytes)
+        : m_count(count), m_bytes(std::move(bytes)) {}
+
+    size_t write(std::vector<uint8_t> &buf) const override
+    {
+        padTo(buf, 4);
+        if ((buf.size() + 4) % 8) {
+            append<uint32_t>(buf, 0);
+        }
+        size_t pos = buf.size();
+        append<uint32_t>(buf, (uint32_t)m_count);
+        buf.insert(buf.end(), m_bytes.begin(), m_bytes.end());
+        return pos;
+    }
+
+private:
+    size_t m_count;
+    std::vector<uint8_t> m_bytes;
+};
+
+class FbTableVector : public FbObject
+{
+public:
+    explicit FbTableVector(std::vector<FbPtr> items) : m_items(std::move(items)) {}
+
+    size_t write(std::vector<uint8_t> &buf) const override
+    {
+        padTo(buf, 4);
+        size_t pos = buf.size();
+        append<uint32_t>(buf, (uint32_t)m_items.size());
+        size_t slots = buf.size();
+        buf.resize(slots + 4 * m_items.size());
+        for (size_t i = 0; i < m_items.size(); ++i) {
+            size_t slot = slots + 4 * i;
+            size_t child = m_items[i]->write(buf);
+            put<uint32_t>(buf, slot, (uint32_t)(child - slot));
+        }
+        return pos;
+    }
+
+private:
+    std::vector<FbPtr> m_items;
+};
+
+class FbTable : public FbObject
+{
+public:
+    FbTable &scalar(int id, uint64_t value, size_t size)
+    {
+        m_fields.push_back(Field{ id, size, value, FbPtr() });
+        return *this;
+    }
+    FbTable &child(int id, FbPtr object)
+    {
+        m_fields.push_back(Field{ id, 4, 0, std::move(object) });
+        return *this;
+    }
+
+    size_t write(std::vector<uint8_t> &buf) const override
+    {
+        // 表内布局：soffset 之后按字段大小降序排列，各字段自然对齐
+        std::vector<const Field *> order;
+        int maxId = -1;
+        size_t tableAlign = 4;
+        for (const Field &f : m_fields) {
+            order.push_back(&f);
+            maxId = std::max(maxId, f.id);
+            tableAlign = std::max(tableAlign, f.size);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const Field *a, const Field *b){
+            return a->size > b->size;
+        });
+        std::vector<size_t> offsets(m_fields.size());
+        size_t inlineSize = 4;
+        for (size_t k = 0; k < order.size(); ++k) {
+            inlineSize = (inlineSize + order[k]->size - 1) / order[k]->size * order[k]->size;
+            offsets[k] = inlineSize;
+            inlineSize += order[k]->size;
+        }
+
+        padTo(buf, 2);
+        size_t vtable = buf.size();
+        size_t vtableSize = 4 + 2 * (size_t)(maxId + 1);
+        buf.resize(vtable + vtableSize, 0);
+        put<uint16_t>(buf, vtable, (uint16_t)vtableSize);
+        put<uint16_t>(buf, vtable + 2, (uint16_t)inlineSize);
+
+        padTo(buf, tableAlign);
+        size_t table = buf.size();
+        buf.resize(table + inlineSize, 0);
+        put<int32_t>(buf, table, (int32_t)(table - vtable));
+
+        for (size_t k = 0; k < order.size(); ++k) {
+            const Field &f = *order[k];
+            put<uint16_t>(buf, vtable + 4 + 2 * (size_t)f.id, (uint16_t)offsets[k]);
+            if (!f.object) {
+                std::memcpy(buf.data() + table + offsets[k], &f.value, f.size);
+            }
+        }
+        for (size_t k = 0; k < order.size(); ++k) {
+            if (order[k]->object) {
+                size_t slot = table + offsets[k];
+                size_t child = order[k]->object->write(buf);
+                put<uint32_t>(buf, slot, (uint32_t)(child - slot));
+            }
+        }
+        return table;
+    }
+
+private:
+    struct Field {
+        int id;
+        size_t size;
+        uint64_t value;
+        FbPtr object;
+    };
+    std::vector<Field> m_fields;
+};
+
+typedef std::shared_ptr<FbTable> FbTablePtr;
+
+static FbTablePtr table()
+{
+    return std::make_shared<FbTable>();
+}
+
+/// 编码为以根表开头的完整 FlatBuffer，长度补齐到 8 字节
+static std::vector<uint8_t> finish(const FbObject &root)
+{
+    std::vector<uint8_t> buf(4, 0);
+    size_t pos = root.write(buf);
+    put<uint32_t>(buf, 0, (uint32_t)pos);
+    padTo(buf, 8);
+    return buf;
+}
+
+// Arrow 的 Field 表：name(0) nullable(1) type_type(2) type(3) children(5)
+static FbPtr field(const std::string &name, uint8_t typeType, FbPtr type)
+{
+    FbTablePtr f = table();
+    f->child(0, std::make_shared<FbString>(name))
+      .scalar(1, 0, 1)
+      .scalar(2, typeType, 1)
+      .child(3, std::move(type))
+      .child(5, std::make_shared<FbTableVector>(std::vector<FbPtr>()));
+    return f;
+}
+
+// Schema 表：endianness(0) fields(1)
+static FbPtr schema(uint32_t columnMask)
+{
+    std::vector<FbPtr> fields;
+    FbTablePtr timestampType = table();
+    timestampType->scalar(0, (uint16_t)kTimeUnitSecond, 2);
+    fields.push_back(field(kTimestampName, kTypeTimestamp, timestampType));
+
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if (!((columnMask >> c) & 1)) {
+            continue;
+        }
+        FbTablePtr floatType = table();
+        floatType->scalar(0, (uint16_t)kPrecisionSingle, 2);
+        fields.push_back(field(kChannelNames[c], kTypeFloatingPoint, floatType));
+    }
+
+    FbTablePtr s = table();
+    s->scalar(0, 0, 2)
+      .child(1, std::make_shared<FbTableVector>(std::move(fields)));
+    return s;
+}
+
+// Message 表：version(0) header_type(1) header(2) bodyLength(3)
+static std::vector<uint8_t> message(uint8_t headerType, FbPtr header, int64_t bodyLength)
+{
+    FbTable m;
+    m.scalar(0, (uint16_t)kMetadataV5, 2)
+     .scalar(1, headerType, 1)
+     .child(2, std::move(header))
+     .scalar(3, (uint64_t)bodyLength, 8);
+    return finish(m);
+}
+
+static void appendInt64(std::vector<uint8_t> &bytes, int64_t value)
+{
+    append<int64_t>(bytes, value);
+}
+
+} // namespace
+
+ArrowWriter::ArrowWriter(const std::string &filename, size_t batchRows, uint32_t columnMask)
+    : m_filename(filename)
+    , m_batchRows(batchRows ? batchRows : 1)
+    , m_columnMask(columnMask)
+    , m_columnCount(columnCount(columnMask))
+{
+    if (!m_file.open(filename)) {
+        throw std::runtime_error("无法创建文件：" + filename);
+    }
+}
+
+// 批次缓冲在写出器销毁时归还，下一个文件直接复用
+static RecyclePool<std::vector<int64_t>> &timestampPool()
+{
+    static RecyclePool<std::vector<int64_t>> pool(16);
+    return pool;
+}
+
+static RecyclePool<std::vector<float>> &columnPool()
+{
+    static RecyclePool<std::vector<float>> pool(16 * kChannelCount);
+    return pool;
+}
+
+ArrowWriter::~ArrowWriter()
+{
+    timestampPool().release(std::move(m_timestamps));
+    for (auto &col : m_columns) {
+        columnPool().release(std::move(col));
+    }
+}
+
+// 复制到输出文件的缓冲，满一块即交给后台线程写出
+void ArrowWriter::writeBytes(const void *data, size_t size)
+{
+    const char *p = static_cast<const char *>(data);
+    m_offset += size;
+    while (size > 0) {
+        size_t n = std::min(size, kOutputBlockBytes - m_used);
+        std::memcpy(m_file.buffer() + m_used, p, n);
+        m_used += n;
+        p += n;
+        size -= n;
+        if (m_used == kOutputBlockBytes) {
+            submitBuffer();
+        }
+    }
+}
+
+void ArrowWriter::submitBuffer()
+{
+    size_t size = m_used;
+    m_used = 0;
+    if (!m_file.submit(size)) {
+        throw std::runtime_error("写文件失败：" + m_filename);
+    }
+}
+
+void ArrowWriter::writePadding(size_t size)
+{
+    static const char kZeros[8] = {};
+    writeBytes(kZeros, size);
+}
+
+void ArrowWriter::writeHeader()
+{
+    if (m_headerWritten) {
+        return;
+    }
+    m_headerWritten = true;
+
+    writeBytes(kArrowMagic, 6);
+    writePadding(2);
+
+    std::vector<uint8_t> meta = message(kHeaderSchema, schema(m_columnMask), 0);
+    uint32_t prefix[2] = { 0xFFFFFFFFu, (uint32_t)meta.size() };
+    writeBytes(prefix, sizeof(prefix));
+    writeBytes(meta.data(), meta.size());
+
+    size_t reserveRows = std::min(m_batchRows, (size_t)65536);
+    m_timestamps = timestampPool().acquire();
+    m_timestamps.reserve(reserveRows);
+    for (size_t c = 0; c < m_columnCount; ++c) {
+        m_columns[c] = columnPool().acquire();
+        m_columns[c].reserve(reserveRows);
+    }
+}
+
+void ArrowWriter::writeRow(uint64_t ts, const float *values, size_t count)
+{
+    if (count != m_columnCount) {
+        throw std::runtime_error("Arrow 输出的通道数与表头不一致：" + m_filename);
+    }
+    if (!m_headerWritten) {
+        writeHeader();
+    }
+    m_timestamps.push_back(timestampToEpochSeconds(ts));
+    for (size_t c = 0; c < m_columnCount; ++c) {
+        m_columns[c].push_back(values[c]);
+    }
+    if (m_timestamps.size() >= m_batchRows) {
+        writeBatch();
+    }
+}
+
+void ArrowWriter::writeBatch()
+{
+    size_t rows = m_timestamps.size();
+    if (rows == 0) {
+        return;
+    }
+
+    // 每列两个缓冲区：有效位图（无空值，长度为0）与数据，数据在消息体中按8字节对齐
+    std::vector<uint8_t> nodes;
+    std::vector<uint8_t> buffers;
+    int64_t bodyLength = 0;
+    auto addColumn = [&](size_t bytes){
+        appendInt64(nodes, (int64_t)rows);
+        appendInt64(nodes, 0);
+        appendInt64(buffers, bodyLength);
+        appendInt64(buffers, 0);
+        appendInt64(buffers, bodyLength);
+        appendInt64(buffers, (int64_t)bytes);
+        bodyLength += (int64_t)align8(bytes);
+    };
+    addColumn(rows * sizeof(int64_t));
+    for (size_t c = 0; c < m_columnCount; ++c) {
+        addColumn(rows * sizeof(float));
+    }
+
+    // RecordBatch 表：length(0) nodes(1) buffers(2)
+    FbTablePtr batch = table();
+    batch->scalar(0, (uint64_t)rows, 8)
+          .child(1, std::make_shared<FbStructVector>(m_columnCount + 1, std::move(nodes)))
+          .child(2, std::make_shared<FbStructVector>(2 * (m_columnCount + 1), std::move(buffers)));
+    std::vector<uint8_t> meta = message(kHeaderRecordBatch, batch, bodyLength);
+
+    Block block;
+    block.offset = (int64_t)m_offset;
+    block.metadataLength = (int32_t)(8 + meta.size());
+    block.bodyLength = bodyLength;
+    m_blocks.push_back(block);
+
+    uint32_t prefix[2] = { 0xFFFFFFFFu, (uint32_t)meta.size() };
+    writeBytes(prefix, sizeof(prefix));
+    writeBytes(meta.data(), meta.size());
+
+    size_t bytes = rows * sizeof(int64_t);
+    writeBytes(m_timestamps.data(), bytes);
+    writePadding(align8(bytes) - bytes);
+    for (size_t c = 0; c < m_columnCount; ++c) {
+        bytes = rows * sizeof(float);
+        writeBytes(m_columns[c].data(), bytes);
+        writePadding(align8(bytes) - bytes);
+    }
+
+    perfCount(PerfCounter::RowsWritten, rows);
+    m_timestamps.clear();
+    for (auto &col : m_columns) {
+        col.clear();
+    }
+}
+
+void ArrowWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    writeHeader();
+    writeBatch();
+
+    // 流结束标记
+    uint32_t eos[2] = { 0xFFFFFFFFu, 0 };
+    writeBytes(eos, sizeof(eos));
+
+    // Footer 表：version(0) schema(1) dictionaries(2) recordBatches(3)
+    // Block 结构体：offset(int64) metaDataLength(int32) 补齐(4) bodyLength(int64)
+    std::vector<uint8_t> blocks;
+    for (const Block &b : m_blocks) {
+        appendInt64(blocks, b.offset);
+        append<int32_t>(blocks, b.metadataLength);
+        append<int32_t>(blocks, 0);
+        appendInt64(blocks, b.bodyLength);
+    }
+    FbPtr footerSchema = schema(m_columnMask);
+    FbTable footer;
+    footer.scalar(0, (uint16_t)kMetadataV5, 2)
+          .child(1, std::move(footerSchema))
+          .child(2, std::make_shared<FbStructVector>(0, std::vector<uint8_t>()))
+          .child(3, std::make_shared<FbStructVector>(m_blocks.size(), std::move(blocks)));
+    std::vector<uint8_t> meta = finish(footer);
+    writeBytes(meta.data(), meta.size());
+
+    int32_t footerLength = (int32_t)meta.size();
+    writeBytes(&footerLength, sizeof(footerLength));
+    writeBytes(kArrowMagic, 6);
+
+    submitBuffer();
+    if (!m_file.close()) {
+        throw std::runtime_error("写文件失败：" + m_filename);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef ARROWWRITER_H
+#define ARROWWRITER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "outputfile.h"
+#include "recordsink.h"
+#include "recordtable.h"
+
+/// Arrow 输出每个记录批次的行数（约 56MB 列数据）
+static const size_t kArrowBatchRows = 1 << 20;
+
+/**
+ * @brief ArrowWriter
+ *  Arrow IPC 文件（Feather v2）写出器，pandas / pyarrow / polars / DuckDB 可直接读取。
+ *  列为 "时间"（timestamp[s]，不带时区）+ columnMask 中各通道的 float32 列，列名与CSV表头一致；
+ *  无字典、无空值、不压缩，行在内存中攒满 batchRows 后作为一个记录批次写出。
+ *  经 OutputFile 异步整块写出，close() 成功后文件才出现。
+ *  打开或写入失败抛出 std::runtime_error。
+ */
+class ArrowWriter : public RecordSink
+{
+public:
+    explicit ArrowWriter(const std::string &filename, size_t batchRows = kArrowBatchRows,
+                         uint32_t columnMask = kAllColumns);
+    ~ArrowWriter() override;
+
+    ArrowWriter(const ArrowWriter &) = delete;
+    ArrowWriter &operator=(const ArrowWriter &) = delete;
+
+    /// 写文件头与 schema；未调用时在第一次写行或关闭时自动写出
+    void writeHeader() override;
+    /// count 必须为 columnMask 中的列数
+    void writeRow(uint64_t ts, const float *values, size_t count) override;
+    /// 写出剩余行与文件尾并关闭文件，失败时抛出异常
+    void close() override;
+
+private:
+    /// 文件中一个记录批次的位置，写在文件尾的索引中
+    struct Block {
+        int64_t offset;
+        int32_t metadataLength;
+        int64_t bodyLength;
+    };
+
+    void writeBatch();
+    void writeBytes(const void *data, size_t size);
+    void writePadding(size_t size);
+    void submitBuffer();
+
+    std::string m_filename;
+    OutputFile m_file;
+    size_t m_used = 0;          ///< m_file 当前缓冲中已写入的字节
+    size_t m_batchRows;
+    uint32_t m_columnMask;
+    size_t m_columnCount;
+    bool m_headerWritten = false;
+    uint64_t m_offset = 0;
+    std::vector<int64_t> m_timestamps;
+    std::array<std::vector<float>, kChannelCount> m_columns;    ///< 前 m_columnCount 个为输出列
+    std::vector<Block> m_blocks;
+};
+
+#endif // ARROWWRITER_H
@@ -0,0 +1,291 @@
+#include "bingen.h"
+#include "recordtable.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static const size_t kWriteBufferBytes = 1 << 20;
+static const uint64_t kMeanBlankRunBlocks = 64;    // 空白段平均长度（默认布局约 8KB）
+
+// splitmix64，跨平台结果一致
+class BinGenRandom
+{
+public:
+    explicit BinGenRandom(uint64_t seed) : m_state(seed) {}
+
+    uint64_t next()
+    {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// [0, 1) 均匀分布
+    double uniform() { return (double)(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t m_state;
+};
+
+// 逐秒推进的日历时间
+struct GenClock {
+    int year = 2023, month = 6, day = 1, hour = 0, minute = 0, second = 0;
+
+    uint64_t packed() const { return packTimestamp(year, month, day, hour, minute, second); }
+
+    void tick()
+    {
+        static const int kDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        if (++second < 60) return;
+        second = 0;
+        if (++minute < 60) return;
+        minute = 0;
+        if (++hour < 24) return;
+        hour = 0;
+        bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        int days = kDays[month - 1] + (month == 2 && leap ? 1 : 0);
+        if (++day <= days) return;
+        day = 1;
+        if (++month <= 12) return;
+        month = 1;
+        ++year;
+    }
+};
+
+static inline uint32_t toBcd(int v)
+{
+    return (uint32_t)(((v / 10) << 4) | (v % 10));
+}
+
+static inline void storeBigEndian32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static inline void storeLittleEndian32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+// 控制器的时间字 "YYMMDDhh"、"mmss0000"
+static void timeWords(uint64_t ts, uint32_t &w1, uint32_t &w2)
+{
+    w1 = (toBcd(timestampYear(ts) - 2000) << 24) | (toBcd(timestampMonth(ts)) << 16) |
+         (toBcd(timestampDay(ts)) << 8) | toBcd(timestampHour(ts));
+    w2 = (toBcd(timestampMinute(ts)) << 24) | (toBcd(timestampSecond(ts)) << 16);
+}
+
+namespace {
+
+class GroupGenerator
+{
+public:
+    GroupGenerator(const BinGenOptions &options, BinGenStats &stats)
+        : m_options(options), m_layout(options.layout), m_stats(stats), m_random(options.seed)
+    {
+        for (size_t c = 0; c < kChannelCount; ++c) {
+            m_values[c] = 20.0 + 7.5 * (double)c;
+        }
+    }
+
+    // 写出一组（groupBytes 字节）
+    void write(unsigned char *p)
+    {
+        ++m_stats.groups;
+        double r = m_random.uniform();
+        if (r < m_options.corruptRatio) {
+            writeCorrupt(p);
+            return;
+        }
+        r -= m_options.corruptRatio;
+
+        uint64_t ts;
+        if (r < m_options.duplicateRatio && m_hasLast) {
+            ts = m_last;
+        } else if (m_hasPending) {
+            ts = m_pending;
+            m_hasPending = false;
+            ++m_stats.uniqueRows;
+        } else {
+            ts = m_clock.packed();
+            m_clock.tick();
+            if (m_random.uniform() < m_options.swapRatio) {
+                // 先写后一秒，前一秒留到下一条
+                m_pending = ts;
+                m_hasPending = true;
+                ts = m_clock.packed();
+                m_clock.tick();
+            }
+            ++m_stats.uniqueRows;
+        }
+        if (m_stats.validGroups == 0 || ts < m_stats.firstTimestamp) {
+            m_stats.firstTimestamp = ts;
+        }
+        m_stats.lastTimestamp = std::max(m_stats.lastTimestamp, ts);
+        ++m_stats.validGroups;
+        m_last = ts;
+        m_hasLast = true;
+
+        std::memset(p, 0, m_layout.groupBytes());
+        if (m_layout.skipFirstGroupItem) {
+            storeBigEndian32(p, (uint32_t)m_stats.groups);
+        }
+        uint32_t w1, w2;
+        timeWords(ts, w1, w2);
+        storeBigEndian32(p + m_layout.wordOffset(m_layout.timeIndex[0]), w1);
+        storeBigEndian32(p + m_layout.wordOffset(m_layout.timeIndex[1]), w2);
+        for (size_t c = 0; c < kChannelCount; ++c) {
+            m_values[c] += (m_random.uniform() - 0.5) * 0.2 * (double)(c + 1);
+            float f = (float)m_values[c];
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            // 控制器的 float 按小端存放（解析时大端读字后再交换字节）
+            storeLittleEndian32(p + m_layout.wordOffset(m_layout.floatStartIndex + c), bits);
+        }
+    }
+
+private:
+    void writeCorrupt(unsigned char *p)
+    {
+        size_t bytes = m_layout.groupBytes();
+        uint64_t kind = m_random.next() % 4;
+        if (kind == 0) {
+            std::memset(p, 0xFF, bytes);        // 擦除后未写入的闪存
+            return;
+        }
+        std::memset(p, 0, bytes);               // kind 1：全0，月份为0
+        if (kind == 1) {
+            return;
+        }
+        uint32_t w1, w2;
+        timeWords(m_clock.packed(), w1, w2);
+        if (kind == 2) {
+            w2 |= 0x0A000000;                    // 分钟个位不是十进制数字
+        } else {
+            w1 = (w1 & 0xFF00FFFF) | 0x00130000; // 13月
+        }
+        storeBigEndian32(p + m_layout.wordOffset(m_layout.timeIndex[0]), w1);
+        storeBigEndian32(p + m_layout.wordOffset(m_layout.timeIndex[1]), w2);
+    }
+
+    const BinGenOptions &m_options;
+    const RecordLayout &m_layout;
+    BinGenStats &m_stats;
+    BinGenRandom m_random;
+    GenClock m_clock;
+    double m_values[kChannelCount];
+    uint64_t m_last = 0;
+    bool m_hasLast = false;
+    uint64_t m_pending = 0;
+    bool m_hasPending = false;
+};
+
+} // namespace
+
+// 按块写满 block（size 字节），块尾不足一组的部分填0
+static void fillBlock(GroupGenerator &groups, const RecordLayout &layout, unsigned char *block,
+                      size_t size)
+{
+    size_t g = 0;
+    for (; g + layout.groupBytes() <= size; g += layout.groupBytes()) {
+        groups.write(block + g);
+    }
+    std::memset(block + g, 0, size - g);
+}
+
+BinGenStats generateBinFile(const std::string &path, const BinGenOptions &options)
+{
+    const RecordLayout &layout = options.layout;
+    layout.validate();
+
+    FILE *fp = std::fopen(path.c_str(), "wb");
+    if (!fp) {
+        throw std::runtime_error("无法创建文件：" + path);
+    }
+    BinGenStats stats;
+    GroupGenerator groups(options, stats);
+    std::vector<unsigned char> buffer;
+    buffer.reserve(kWriteBufferBytes + layout.initialBlockSize + layout.subsequentBlockSize);
+    bool ok = true;
+    auto flush = [&]{
+        if (!buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), fp) != buffer.size()) {
+            ok = false;
+        }
+        stats.bytes += buffer.size();
+        buffer.clear();
+    };
+
+    // 文件头与首块开头丢弃的 uint32
+    buffer.resize(layout.fileOffset + 4, 0);
+    static const char kMagic[] = "BINGEN";
+    std::memcpy(buffer.data(), kMagic, std::min<size_t>(layout.fileOffset, sizeof(kMagic) - 1));
+    if (layout.separateHead()) {
+        size_t base = buffer.size();
+        buffer.resize(base + layout.initialBlockSize - 4);
+        fillBlock(groups, layout, buffer.data() + base, layout.initialBlockSize - 4);
+    }
+
+    uint64_t blockCount = 0;
+    uint64_t dataOffset = layout.dataOffset();
+    if (options.bytes > dataOffset) {
+        uint64_t span = options.bytes - dataOffset;
+        blockCount = (span + layout.subsequentBlockSize - 1) / layout.subsequentBlockSize;
+    }
+    // 空白段：每个非空白块后以概率 q 开始一段平均 L 块的空白，空白块占比 qL / (1 + qL)
+    if (!(options.blankRatio >= 0.0 && options.blankRatio < 1.0)) {
+        std::fclose(fp);
+        std::remove(path.c_str());
+        throw std::runtime_error("空白块占比必须在 [0, 1) 内");
+    }
+    BinGenRandom blankRandom(options.seed ^ 0x5DEECE66DULL);
+    double blankStart = options.blankRatio / ((double)kMeanBlankRunBlocks * (1.0 - options.blankRatio));
+    uint64_t blankLeft = 0;
+    unsigned char blankByte = 0;
+    size_t groupsPerBlock = layout.subsequentBlockSize / layout.groupBytes();
+    // 移到末尾的一段块 [displacedFirst, displacedEnd) 先生成到 displaced 中
+    uint64_t displacedCount = std::min(options.displacedBlocks, blockCount);
+    uint64_t displacedFirst = (blockCount - displacedCount) / 2;
+    uint64_t displacedEnd = displacedFirst + displacedCount;
+    std::vector<unsigned char> displaced;
+
+    for (uint64_t b = 0; b < blockCount && ok; ++b) {
+        std::vector<unsigned char> &target =
+                b >= displacedFirst && b < displacedEnd ? displaced : buffer;
+        size_t base = target.size();
+        target.resize(base + layout.subsequentBlockSize);
+        if (blankLeft == 0 && blankStart > 0.0 && blankRandom.uniform() < blankStart) {
+            blankLeft = 1 + blankRandom.next() % (2 * kMeanBlankRunBlocks - 1);
+            blankByte = (blankRandom.next() & 1) ? 0xFF : 0x00;
+        }
+        if (blankLeft > 0) {
+            --blankLeft;
+            std::memset(target.data() + base, blankByte, layout.subsequentBlockSize);
+            stats.groups += groupsPerBlock;
+            ++stats.blankBlocks;
+        } else {
+            fillBlock(groups, layout, target.data() + base, layout.subsequentBlockSize);
+        }
+        if (buffer.size() >= kWriteBufferBytes) {
+            flush();
+        }
+    }
+    buffer.insert(buffer.end(), displaced.begin(), displaced.end());
+    buffer.insert(buffer.end(), options.tailBytes, (unsigned char)0x5A);
+    flush();
+
+    if (std::fclose(fp) != 0 || !ok) {
+        std::remove(path.c_str());
+        throw std::runtime_error("写文件失败：" + path);
+    }
+    return stats;
+}
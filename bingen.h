@@ -0,0 +1,44 @@
+#ifndef BINGEN_H
+#define BINGEN_H
+
+#include <cstdint>
+#include <string>
+
+#include "recordlayout.h"
+
+/// 合成 bin 文件的参数
+struct BinGenOptions {
+    uint64_t bytes = 1 << 20;           ///< 目标大小，按整块向上取到块边界
+    RecordLayout layout;                ///< 写出的记录布局
+    uint64_t seed = 1;                  ///< 伪随机种子，相同参数生成的文件逐字节相同
+    double corruptRatio = 0.01;         ///< 时间非法的组占比（全0xFF、全0、BCD越界、月份越界）
+    double duplicateRatio = 0.005;      ///< 与上一条时间戳相同的组占比
+    double swapRatio = 0.0;             ///< 相邻两条时间戳对调的比例，非0时输入不再有序
+    double blankRatio = 0.0;            ///< 整块全0x00或全0xFF（成段的空白闪存页）的块占比，须小于1
+    size_t tailBytes = 0;               ///< 文件末尾追加的不足一块的字节数
+    /// 从中部取出连续的这么多块移到数据末尾，模拟控制器时钟回拨后成段回退的时间戳；
+    /// 非0时输入不再有序
+    uint64_t displacedBlocks = 0;
+};
+
+/// 生成结果，可用来核对解析输出
+struct BinGenStats {
+    uint64_t bytes = 0;                 ///< 实际写出的字节数
+    uint64_t groups = 0;                ///< 写出的组数（含空白块中的组）
+    uint64_t blankBlocks = 0;           ///< 空白块数
+    uint64_t validGroups = 0;           ///< 时间合法、解析后应得到的行数
+    uint64_t uniqueRows = 0;            ///< 去重后应写出的行数
+    uint64_t firstTimestamp = 0;        ///< 最早的打包时间戳
+    uint64_t lastTimestamp = 0;         ///< 最晚的打包时间戳
+};
+
+/**
+ * @brief generateBinFile
+ *  按布局写出一个模拟控制器记录的 bin 文件：时间从 2023-06-01 00:00:00 起逐秒递增，
+ *  13 个通道为各自的随机游走，按设定比例混入非法时间组、重复时间戳、相邻乱序
+ *  和成段的空白页，可把中部的一段块移到末尾。
+ *  用于基准测试与快速路径的输出比对。写文件失败时抛出 std::runtime_error。
+ */
+BinGenStats generateBinFile(const std::string &path, const BinGenOptions &options = BinGenOptions());
+
+#endif // BINGEN_H
@@ -0,0 +1,84 @@
+#include "binpreview.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <system_error>
+
+BinPreview::BinPreview(const std::string &binFilename, const RecordLayout &layout)
+    : m_reader(binFilename, layout)
+{
+    if (!m_reader.mappedBlocks(m_blocks, m_blockCount)) {
+        throw std::runtime_error("只能预览可内存映射的普通文件：" + binFilename);
+    }
+    // 单独的首块读得到时占一组位置，即使其中没有合法的组
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(binFilename, ec);
+    if (layout.separateHead() && !ec && size >= layout.dataOffset()) {
+        m_reader.decodeHead(m_head);
+        m_headRows = (layout.initialBlockSize - 4) / layout.groupBytes();
+    }
+}
+
+void BinPreview::decodePage(Page &page) const
+{
+    size_t first = page.number * kPreviewPageBlocks;
+    size_t count = std::min(kPreviewPageBlocks, m_blockCount - first);
+    size_t rowsPerBlock = m_reader.rowsPerBlock();
+    page.table.resize(count * rowsPerBlock);
+    page.blockStart.resize(count);
+    page.blockRows.resize(count);
+    // 逐块解码，记下每块的记录数，行号才能对回组位置
+    TableSlice out{ &page.table, 0 };
+    const unsigned char *p = m_blocks + first * m_reader.blockSize();
+    for (size_t b = 0; b < count; ++b, p += m_reader.blockSize()) {
+        page.blockStart[b] = out.pos;
+        m_reader.decodeBlocks(p, 1, out);
+        page.blockRows[b] = out.pos - page.blockStart[b];
+    }
+    page.table.resize(out.pos);
+}
+
+BinPreview::Page &BinPreview::page(size_t number)
+{
+    auto it = m_pageIndex.find(number);
+    if (it != m_pageIndex.end()) {
+        m_pages.splice(m_pages.begin(), m_pages, it->second);
+        return m_pages.front();
+    }
+    // 缓存已满时复用最久未访问的页，表的容量保留
+    if (m_pages.size() >= kPreviewCachePages) {
+        m_pageIndex.erase(m_pages.back().number);
+        m_pages.splice(m_pages.begin(), m_pages, std::prev(m_pages.end()));
+    } else {
+        m_pages.emplace_front();
+    }
+    Page &front = m_pages.front();
+    front.number = number;
+    decodePage(front);
+    m_pageIndex[number] = m_pages.begin();
+    return front;
+}
+
+const RecordTable *BinPreview::row(size_t row, size_t &index)
+{
+    if (row < m_headRows) {
+        index = row;
+        return row < m_head.size() ? &m_head : nullptr;
+    }
+    row -= m_headRows;
+    size_t rowsPerBlock = m_reader.rowsPerBlock();
+    size_t block = row / rowsPerBlock;
+    if (block >= m_blockCount) {
+        return nullptr;
+    }
+    const Page &p = page(block / kPreviewPageBlocks);
+    size_t b = block % kPreviewPageBlocks;
+    size_t slot = row % rowsPerBlock;
+    if (slot >= p.blockRows[b]) {
+        return nullptr;
+    }
+    index = p.blockStart[b] + slot;
+    return &p.table;
+}
@@ -0,0 +1,65 @@
+#ifndef BINPREVIEW_H
+#define BINPREVIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "parsebin.h"
+
+/// 预览每页的块数
+static const size_t kPreviewPageBlocks = 256;
+/// 预览最多缓存的页数，超出时丢弃最久未访问的页
+static const size_t kPreviewCachePages = 32;
+
+/**
+ * @brief BinPreview
+ *  按需解码的 bin 文件预览：不整体解析，只解码被访问的行所在的页。
+ *  行号按文件中的组位置排列（单独的首块在前，之后每块 rowsPerBlock 行），
+ *  块等长，任意一行所在的块可直接算出，定位与文件大小无关。
+ *  行按文件顺序给出，不排序、不去重；空白块与时间非法的组没有记录，
+ *  显示为该块末尾的空行。
+ *  解码过的页保存在最多 kPreviewCachePages 页的 LRU 缓存中，来回滚动不必重复解码，
+ *  内存占用与文件大小无关。
+ *  只能预览可内存映射的普通文件；打开失败或布局不合法时抛出 std::runtime_error。
+ *  非线程安全，由界面线程调用。
+ */
+class BinPreview
+{
+public:
+    explicit BinPreview(const std::string &binFilename,
+                        const RecordLayout &layout = RecordLayout());
+
+    /// 行数（组位置数），含空白或非法的组
+    size_t rowCount() const { return m_headRows + m_blockCount * m_reader.rowsPerBlock(); }
+
+    /// 第 row 行所在页的记录表，index 为表中行号；该位置没有记录时返回 nullptr。
+    /// 返回的表在下一次调用前有效
+    const RecordTable *row(size_t row, size_t &index);
+
+private:
+    /// 解码后的一页：table 中各块的记录依次排列，blockRows[b] 为第 b 块的记录数
+    struct Page {
+        size_t number = 0;
+        RecordTable table;
+        std::vector<size_t> blockStart;
+        std::vector<size_t> blockRows;
+    };
+
+    Page &page(size_t number);
+    void decodePage(Page &page) const;
+
+    BinBlockReader m_reader;
+    const unsigned char *m_blocks = nullptr;
+    size_t m_blockCount = 0;
+    RecordTable m_head;             ///< 单独首块的记录
+    size_t m_headRows = 0;          ///< 单独首块的组数
+
+    std::list<Page> m_pages;        ///< 缓存的页，最近访问的在前
+    std::unordered_map<size_t, std::list<Page>::iterator> m_pageIndex;
+};
+
+#endif // BINPREVIEW_H
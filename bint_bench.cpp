@@ -0,0 +1,629 @@
+// bint-bench：解析、格式化、排序去重的基准测试，运行前先核对各快速路径的输出逐字节一致
+//
+// 额外参数（其余交给 Google Benchmark）：
+//   --sizes=1M,100M,5G   输入大小列表（默认 1M,100M）
+//   --dir=<目录>         合成输入与临时输出目录（默认系统临时目录下的 bint-bench）
+//   --no_golden          跳过输出核对
+// 峰值内存在 Linux 下按每项基准分别统计；其他平台为整个进程的峰值，
+// 需要分项数字时用 --benchmark_filter 每次只跑一项。
+// startup/* 测量 bint-cli --help 与 BINT --quit-after-show 从启动到退出的耗时，
+// 用于比较 LTO / PGO 构建（各自的可执行文件路径在构建时写入）。
+
+#include "bingen.h"
+#include "incremental.h"
+#include "outputfile.h"
+#include "parsebin.h"
+#include "streampipeline.h"
+#include "threadpool.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// 字段含义与默认布局相同，但不匹配任何专用解码器，走通用解码，作为比对基准
+static RecordLayout referenceLayout()
+{
+    RecordLayout layout;
+    layout.skipFirstGroupItem = false;
+    layout.timeIndex[0] = 1;
+    layout.timeIndex[1] = 2;
+    layout.floatStartIndex = 3;
+    return layout;
+}
+
+// 进程的峰值常驻内存。Linux 下读 VmHWM，可由 resetPeakRss 清零，从而按基准分项统计
+static uint64_t peakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc));
+    return (uint64_t)pmc.PeakWorkingSetSize;
+#else
+#ifdef __linux__
+    if (FILE *fp = std::fopen("/proc/self/status", "r")) {
+        char line[128];
+        unsigned long long kb = 0;
+        while (std::fgets(line, sizeof(line), fp)) {
+            if (std::sscanf(line, "VmHWM: %llu kB", &kb) == 1) {
+                break;
+            }
+        }
+        std::fclose(fp);
+        if (kb) {
+            return (uint64_t)kb * 1024;
+        }
+    }
+#endif
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+// 把峰值重置为当前常驻内存（仅 Linux），其他平台峰值为整个进程的峰值
+static void resetPeakRss()
+{
+#ifdef __linux__
+    if (FILE *fp = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", fp);
+        std::fclose(fp);
+    }
+#endif
+}
+
+static void reportPeakRss(benchmark::State &state)
+{
+    state.counters["peak_rss_MB"] = (double)peakRssBytes() / (1 << 20);
+}
+
+// 不写任何东西的输出端，用于单独测排序去重
+class NullSink : public RecordSink
+{
+public:
+    void writeHeader() override {}
+    void writeRow(uint64_t ts, const float *values, size_t) override
+    {
+        benchmark::DoNotOptimize(ts);
+        benchmark::DoNotOptimize(values);
+        ++rows;
+    }
+    void close() override {}
+
+    uint64_t rows = 0;
+};
+
+struct BenchInput {
+    std::string label;
+    std::string path;
+    uint64_t bytes = 0;
+    BinGenStats stats;
+};
+
+static std::string g_dir;
+static std::unique_ptr<ThreadPool> g_pool;
+
+// 最近一次解析的表，多个基准共用；同一时间只缓存一个输入
+static const RecordTable &parsedTable(const BenchInput &input)
+{
+    static std::string cachedPath;
+    static RecordTable table;
+    if (cachedPath != input.path) {
+        table = RecordTable();
+        ParseOptions options;
+        options.pool = g_pool.get();
+        parseBinFile(input.path, table, options);
+        cachedPath = input.path;
+    }
+    return table;
+}
+
+static void benchDecode(benchmark::State &state, const BenchInput &input, bool parallel,
+                        const RecordLayout &layout)
+{
+    resetPeakRss();
+    ParseOptions options;
+    options.pool = parallel ? g_pool.get() : nullptr;
+    options.layout = &layout;
+    RecordTable table;
+    for (auto _ : state) {
+        table.clear();
+        parseBinFile(input.path, table, options);
+        benchmark::DoNotOptimize(table.timestamps.data());
+    }
+    state.SetBytesProcessed((int64_t)(state.iterations() * input.bytes));
+    state.SetItemsProcessed((int64_t)(state.iterations() * table.size()));
+    reportPeakRss(state);
+}
+
+static void benchFormat(benchmark::State &state, const BenchInput &input, OutputFormat format)
+{
+    resetPeakRss();
+    const RecordTable &table = parsedTable(input);
+    std::string out = (fs::path(g_dir) / (std::string("format") + outputExtension(format))).string();
+    for (auto _ : state) {
+        std::unique_ptr<RecordSink> sink = openRecordSink(out, format, CsvEncoding::Utf8);
+        writeRecords(*sink, table);
+        sink->close();
+    }
+    std::error_code ec;
+    uint64_t outBytes = fs::file_size(out, ec);
+    fs::remove(out, ec);
+    state.SetItemsProcessed((int64_t)(state.iterations() * input.stats.uniqueRows));
+    state.SetBytesProcessed((int64_t)(state.iterations() * outBytes));
+    reportPeakRss(state);
+}
+
+static void benchSortDedup(benchmark::State &state, const BenchInput &input)
+{
+    resetPeakRss();
+    // 共用的表在计时期间把每 16 行中的前两条时间戳对调（制造乱序），结束后换回
+    RecordTable &table = const_cast<RecordTable &>(parsedTable(input));
+    std::vector<uint64_t> &ts = table.timestamps;
+    auto perturb = [&]{
+        for (size_t i = 0; i + 1 < ts.size(); i += 16) {
+            std::swap(ts[i], ts[i + 1]);
+        }
+    };
+    perturb();
+    NullSink sink;
+    for (auto _ : state) {
+        sink.rows = 0;
+        writeRecords(sink, table);
+    }
+    perturb();
+    state.SetItemsProcessed((int64_t)(state.iterations() * table.size()));
+    state.counters["unique_rows"] = (double)sink.rows;
+    reportPeakRss(state);
+}
+
+static void benchStream(benchmark::State &state, const BenchInput &input)
+{
+    resetPeakRss();
+    std::string out = (fs::path(g_dir) / "stream.csv").string();
+    StreamOptions options;
+    options.tempDir = g_dir;
+    for (auto _ : state) {
+        streamBinToCsv({ input.path }, out, options);
+    }
+    std::error_code ec;
+    fs::remove(out, ec);
+    state.SetBytesProcessed((int64_t)(state.iterations() * input.bytes));
+    reportPeakRss(state);
+}
+
+#if defined(BINT_CLI_PATH) || defined(BINT_GUI_PATH)
+// 每次迭代启动一次 command 并等待退出；耗时包含 shell 本身，比较不同构建时不受影响
+static void benchStartup(benchmark::State &state, const std::string &command)
+{
+#ifdef _WIN32
+    const std::string line = "\"" + command + " > NUL 2>&1\"";
+#else
+    const std::string line = command + " > /dev/null 2>&1";
+#endif
+    for (auto _ : state) {
+        if (std::system(line.c_str()) != 0) {
+            state.SkipWithError(("启动失败：" + command).c_str());
+            break;
+        }
+    }
+}
+#endif
+
+static bool readWholeFile(const std::string &path, std::string &content)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// 把 path 原样写成 gzip 压缩的 gzPath
+static bool writeGzipCopy(const std::string &path, const std::string &gzPath)
+{
+    std::ifstream in(path, std::ios::binary);
+    OutputFile out;
+    if (!in || !out.open(gzPath)) {
+        return false;
+    }
+    while (in) {
+        in.read(out.buffer(), (std::streamsize)kOutputBlockBytes);
+        if (in.gcount() > 0 && !out.submit((size_t)in.gcount())) {
+            return false;
+        }
+    }
+    return out.close();
+}
+
+// 增量转换：未变的输入第二次应直接判为最新；压缩输入的大小与解码位置不可比，应被拒绝且不留下输出
+static bool checkIncremental(const BenchInput &input, const std::string &output)
+{
+    AppendOptions options;
+    options.encoding = CsvEncoding::Utf8;
+    bool ok = true;
+    if (!appendBinToCsv(input.path, output, options).upToDate) {
+        std::fprintf(stderr, "%s：增量转换未改动的输入时没有判为最新\n", input.label.c_str());
+        ok = false;
+    }
+    std::error_code ec;
+    fs::remove(output, ec);
+    fs::remove(checkpointPathFor(output), ec);
+
+    if (compressionAvailable(OutputCompression::Gzip)) {
+        std::string gz = (fs::path(g_dir) / "golden.bin.gz").string();
+        bool rejected = false;
+        if (writeGzipCopy(input.path, gz)) {
+            try {
+                appendBinToCsv(gz, output, options);
+            } catch (const std::runtime_error &) {
+                rejected = true;
+            }
+        }
+        if (!rejected || fs::exists(output, ec) || fs::exists(checkpointPathFor(output), ec)) {
+            std::fprintf(stderr, "%s：增量转换没有拒绝压缩输入\n", input.label.c_str());
+            ok = false;
+        }
+        fs::remove(gz, ec);
+    }
+    return ok;
+}
+
+// 时间范围查询（解析与流式）与完整解析后按同一范围筛选的结果比对。
+// 范围取自文件开头附近与文件末尾的行：有被移到末尾的一段时，后者正落在回退的时间里
+static bool checkTimeRange(const BenchInput &input, const RecordTable &full)
+{
+    size_t n = full.size();
+    if (n < 2) {
+        return true;
+    }
+    const std::vector<uint64_t> &ts = full.timestamps;
+    const size_t picks[][2] = { { n / 4, std::min(n - 1, n / 4 + 60) },
+                                { n > 60 ? n - 60 : 0, n - 1 } };
+    std::string expectedPath = (fs::path(g_dir) / "golden-range-ref.csv").string();
+    std::string actualPath = (fs::path(g_dir) / "golden-range-out.csv").string();
+    bool ok = true;
+    for (const auto &pick : picks) {
+        RecordQuery query;
+        query.begin = std::min(ts[pick[0]], ts[pick[1]]);
+        query.end = std::max(ts[pick[0]], ts[pick[1]]);
+        if (query.begin == query.end) {
+            continue;
+        }
+        RecordTable selected;
+        float values[kChannelCount];
+        for (size_t i = 0; i < n; ++i) {
+            if (ts[i] >= query.begin && ts[i] < query.end) {
+                full.gatherRow(i, values);
+                selected.append(ts[i], values);
+            }
+        }
+        writeCsv(expectedPath, selected, CsvEncoding::Utf8);
+        std::string expected;
+        readWholeFile(expectedPath, expected);
+
+        RecordTable table;
+        ParseOptions parse;
+        parse.query = &query;
+        parseBinFile(input.path, table, parse);
+        writeCsv(actualPath, table, CsvEncoding::Utf8);
+        std::string actual;
+        if (!readWholeFile(actualPath, actual) || actual != expected) {
+            std::fprintf(stderr, "%s：时间范围查询的输出与筛选完整结果不一致\n", input.label.c_str());
+            ok = false;
+        }
+        StreamOptions stream;
+        stream.encoding = CsvEncoding::Utf8;
+        stream.tempDir = g_dir;
+        stream.query = &query;
+        streamBinToCsv({ input.path }, actualPath, stream);
+        if (!readWholeFile(actualPath, actual) || actual != expected) {
+            std::fprintf(stderr, "%s：流式时间范围查询的输出与筛选完整结果不一致\n", input.label.c_str());
+            ok = false;
+        }
+    }
+    std::error_code ec;
+    fs::remove(expectedPath, ec);
+    fs::remove(actualPath, ec);
+    return ok;
+}
+
+// 各快速路径与通用解码 + 串行写出的结果逐字节比对，行数与生成器的统计比对
+static bool checkGolden(const BenchInput &input)
+{
+    const RecordLayout generic = referenceLayout();
+    fs::path dir(g_dir);
+    std::string reference = (dir / "golden-ref.csv").string();
+    {
+        RecordTable table;
+        ParseOptions options;
+        options.layout = &generic;
+        parseBinFile(input.path, table, options);
+        if (table.size() != input.stats.validGroups) {
+            std::fprintf(stderr, "%s：解析出 %zu 行，应为 %" PRIu64 " 行\n", input.label.c_str(),
+                         table.size(), input.stats.validGroups);
+            return false;
+        }
+        NullSink counter;
+        writeRecords(counter, table);
+        if (counter.rows != input.stats.uniqueRows) {
+            std::fprintf(stderr, "%s：去重后 %" PRIu64 " 行，应为 %" PRIu64 " 行\n",
+                         input.label.c_str(), counter.rows, input.stats.uniqueRows);
+            return false;
+        }
+        writeCsv(reference, table, CsvEncoding::Utf8);
+        if (!checkTimeRange(input, table)) {
+            return false;
+        }
+    }
+    std::string expected;
+    readWholeFile(reference, expected);
+
+    struct Variant {
+        const char *name;
+        void (*run)(const BenchInput &, const std::string &);
+    };
+    static const Variant kVariants[] = {
+        { "专用解码 串行", [](const BenchInput &in, const std::string &out){
+            RecordTable table;
+            parseBinFile(in.path, table, ParseOptions());
+            writeCsv(out, table, CsvEncoding::Utf8);
+        } },
+        { "专用解码 并行", [](const BenchInput &in, const std::string &out){
+            RecordTable table;
+            ParseOptions options;
+            options.pool = g_pool.get();
+            parseBinFile(in.path, table, options);
+            writeCsv(out, table, CsvEncoding::Utf8);
+        } },
+        { "流式", [](const BenchInput &in, const std::string &out){
+            StreamOptions options;
+            options.encoding = CsvEncoding::Utf8;
+            options.tempDir = g_dir;
+            streamBinToCsv({ in.path }, out, options);
+        } },
+        { "流式 小批次", [](const BenchInput &in, const std::string &out){
+            StreamOptions options;
+            options.encoding = CsvEncoding::Utf8;
+            options.tempDir = g_dir;
+            options.batchBlocks = 256;
+            options.sortRunRows = 4096;
+            streamBinToCsv({ in.path }, out, options);
+        } },
+        { "增量", [](const BenchInput &in, const std::string &out){
+            std::remove(checkpointPathFor(out).c_str());
+            AppendOptions options;
+            options.encoding = CsvEncoding::Utf8;
+            appendBinToCsv(in.path, out, options);
+        } },
+    };
+
+    bool ok = true;
+    std::string output = (dir / "golden-out.csv").string();
+    for (const Variant &v : kVariants) {
+        v.run(input, output);
+        std::string actual;
+        if (!readWholeFile(output, actual) || actual != expected) {
+            std::fprintf(stderr, "%s：%s 的输出与基准不一致\n", input.label.c_str(), v.name);
+            ok = false;
+        }
+    }
+    // 紧接“增量”一项：输出与断点仍在
+    ok = checkIncremental(input, output) && ok;
+#ifdef BINT_CLI_PATH
+    {
+        // 标准输入只能读一遍：流式转换遇到乱序不能重新解析
+        std::string command = "\"" BINT_CLI_PATH "\" -q --stream --encoding utf8 --merge \"" +
+                              output + "\" - < \"" + input.path + "\"";
+#ifdef _WIN32
+        command = "\"" + command + "\"";
+#endif
+        std::string actual;
+        if (std::system(command.c_str()) != 0 || !readWholeFile(output, actual) ||
+            actual != expected) {
+            std::fprintf(stderr, "%s：bint-cli --stream 从标准输入读取的输出与基准不一致\n",
+                         input.label.c_str());
+            ok = false;
+        }
+    }
+#endif
+    std::error_code ec;
+    fs::remove(reference, ec);
+    fs::remove(output, ec);
+    return ok;
+}
+
+// K/M/G 后缀的大小
+static bool parseSize(const std::string &text, uint64_t &bytes)
+{
+    char *end = nullptr;
+    unsigned long long v = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    int shift = *end == 'K' ? 10 : *end == 'M' ? 20 : *end == 'G' ? 30 : 0;
+    if (shift) {
+        ++end;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    bytes = (uint64_t)v << shift;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string sizes = "1M,100M";
+    bool golden = true;
+    g_dir = (fs::temp_directory_path() / "bint-bench").string();
+
+    // 取出自己的参数，其余交给 Google Benchmark
+    int kept = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--sizes=", 8) == 0) {
+            sizes = argv[i] + 8;
+        } else if (std::strncmp(argv[i], "--dir=", 6) == 0) {
+            g_dir = argv[i] + 6;
+        } else if (std::strcmp(argv[i], "--no_golden") == 0) {
+            golden = false;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 2;
+    }
+
+    std::error_code ec;
+    fs::create_directories(g_dir, ec);
+    g_pool.reset(new ThreadPool(0));
+
+    static std::vector<BenchInput> inputs;
+    static std::vector<BenchInput> padded;     // 一半为空白页，测整块跳过
+    size_t start = 0;
+    while (start <= sizes.size()) {
+        size_t comma = sizes.find(',', start);
+        std::string label = sizes.substr(start, comma == std::string::npos ? std::string::npos
+                                                                           : comma - start);
+        start = comma == std::string::npos ? sizes.size() + 1 : comma + 1;
+        BenchInput input;
+        if (!parseSize(label, input.bytes) || input.bytes == 0) {
+            std::fprintf(stderr, "bint-bench: 无效的大小：%s\n", label.c_str());
+            return 2;
+        }
+        input.label = label;
+        input.path = (fs::path(g_dir) / ("gen-" + label + ".bin")).string();
+        inputs.push_back(input);
+        input.label = label;
+        input.path = (fs::path(g_dir) / ("gen-" + label + "-padded.bin")).string();
+        padded.push_back(input);
+    }
+
+    try {
+        if (golden) {
+            // 乱序输入走排序与外部排序路径，单独核对一次
+            BenchInput unordered;
+            unordered.label = "unordered";
+            unordered.path = (fs::path(g_dir) / "gen-unordered.bin").string();
+            BinGenOptions options;
+            options.bytes = 4 << 20;
+            options.swapRatio = 0.01;
+            options.tailBytes = 100;
+            unordered.stats = generateBinFile(unordered.path, options);
+            bool ok = checkGolden(unordered);
+            fs::remove(unordered.path, ec);
+            if (!ok) {
+                return 1;
+            }
+            // 中部一段移到末尾（时钟回拨）：抽样看来有序，时间范围查询不能据此截取块
+            BenchInput displaced;
+            displaced.label = "displaced";
+            displaced.path = (fs::path(g_dir) / "gen-displaced.bin").string();
+            options = BinGenOptions();
+            options.bytes = 4 << 20;
+            options.displacedBlocks = 300;
+            displaced.stats = generateBinFile(displaced.path, options);
+            ok = checkGolden(displaced);
+            fs::remove(displaced.path, ec);
+            if (!ok) {
+                return 1;
+            }
+        }
+        for (BenchInput &input : inputs) {
+            BinGenOptions options;
+            options.bytes = input.bytes;
+            input.stats = generateBinFile(input.path, options);
+            input.bytes = input.stats.bytes;
+            if (golden && !checkGolden(input)) {
+                return 1;
+            }
+        }
+        for (BenchInput &input : padded) {
+            BinGenOptions options;
+            options.bytes = input.bytes;
+            options.blankRatio = 0.5;
+            input.stats = generateBinFile(input.path, options);
+            input.bytes = input.stats.bytes;
+            if (golden && !checkGolden(input)) {
+                return 1;
+            }
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "bint-bench: %s\n", e.what());
+        return 1;
+    }
+
+    static const RecordLayout kDefault;
+    static const RecordLayout kGeneric = referenceLayout();
+    for (const BenchInput &input : inputs) {
+        const std::string &n = input.label;
+        benchmark::RegisterBenchmark(("decode/parallel/" + n).c_str(), benchDecode, input, true, kDefault)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+        benchmark::RegisterBenchmark(("decode/serial/" + n).c_str(), benchDecode, input, false, kDefault)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("decode/generic/" + n).c_str(), benchDecode, input, false, kGeneric)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("format/csv/" + n).c_str(), benchFormat, input, OutputFormat::Csv)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("format/arrow/" + n).c_str(), benchFormat, input, OutputFormat::Arrow)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("sort_dedup/" + n).c_str(), benchSortDedup, input)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("stream/" + n).c_str(), benchStream, input)
+            ->Unit(benchmark::kMillisecond)->UseRealTime();
+    }
+    for (const BenchInput &input : padded) {
+        const std::string &n = input.label;
+        benchmark::RegisterBenchmark(("decode/padded/" + n).c_str(), benchDecode, input, false, kDefault)
+            ->Unit(benchmark::kMillisecond);
+        benchmark::RegisterBenchmark(("decode/padded_generic/" + n).c_str(), benchDecode, input, false, kGeneric)
+            ->Unit(benchmark::kMillisecond);
+    }
+#ifdef BINT_CLI_PATH
+    benchmark::RegisterBenchmark("startup/cli", benchStartup,
+                                 std::string("\"" BINT_CLI_PATH "\" --help"))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+#ifdef BINT_GUI_PATH
+    benchmark::RegisterBenchmark("startup/gui", benchStartup,
+                                 std::string("\"" BINT_GUI_PATH "\" --quit-after-show"))
+        ->Unit(benchmark::kMillisecond)->UseRealTime();
+#endif
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    for (const BenchInput &input : inputs) {
+        fs::remove(input.path, ec);
+    }
+    for (const BenchInput &input : padded) {
+        fs::remove(input.path, ec);
+    }
+    return 0;
+}
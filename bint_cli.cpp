@@ -0,0 +1,649 @@
+// bint-cli：不依赖 Qt 的批量转换命令行工具，供无显示环境的定时任务使用
+
+#include "converter.h"
+#include "folderwatcher.h"
+#include "inputsource.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static std::atomic<bool> g_cancel(false);
+
+static void onSignal(int)
+{
+    g_cancel.store(true);
+}
+
+static void printUsage(FILE *out)
+{
+    std::fputs(
+        "用法: bint-cli [选项] <文件|目录|通配符>...\n"
+        "\n"
+        "将 .bin 文件转换为 CSV 或 Arrow。目录会展开为其中的 .bin 文件；\n"
+        "通配符（* 和 ?，仅限文件名部分）由程序自行展开，不依赖 shell。\n"
+        "输入也可以是 .bin.gz / .bin.zst（边读边解压，不生成临时文件）、.zip 压缩包\n"
+        "（展开为包内的 .bin，也可写作 <包.zip>!<项名> 只取一项）或 - （从标准输入读取）。\n"
+        "\n"
+        "选项:\n"
+        "  --separate          每个 bin 输出同名 .csv / .arrow（默认）\n"
+        "  --merge <文件>      按时间合并输出为一个文件\n"
+        "  -o, --output-dir <目录>\n"
+        "                      输出目录（默认与 bin 同目录；--merge 的相对路径也相对于此目录）\n"
+        "  -j, --jobs <N>      工作线程数（默认按硬件线程数）\n"
+        "  -r, --recursive     递归展开目录\n"
+        "  --watch             监视输入目录，新的 bin 文件写完后即按所选方式转换，直到 Ctrl+C；\n"
+        "                      已有文件中输出比输入新的跳过，--merge 时有新文件即重新合并\n"
+        "  --settle <毫秒>     监视时文件大小与修改时间保持不变多久视为写完（默认 300）\n"
+        "  --stream            流式转换，内存占用与文件大小无关\n"
+        "  --memory <MB>       合并输出可使用的内存（默认 2048，0 为不限）；预计超出时\n"
+        "                      分段排序写入临时文件后归并，结果相同\n"
+        "  --temp-dir <目录>   外部排序临时文件目录（默认为系统临时目录）\n"
+        "  --cache <目录>      结果缓存：按输入内容指纹与选项记录结果，分别输出时未变的文件直接跳过，\n"
+        "                      --merge 时各文件的有序段存入缓存、只解析新文件（--stream 除外）；\n"
+        "                      目录可随时删除；每个输入只保留最新一组段\n"
+        "  --cache-size <MB>   缓存中有序段的总大小上限（默认 0 为不限），超出时删除最久未用的\n"
+        "  --incremental       增量转换：只解析上次之后新增的块并追加到已有 CSV\n"
+        "                      （断点保存在 <csv>.ckpt，仅限 --separate 与不压缩的 csv）\n"
+        "  --format <csv|arrow>\n"
+        "                      输出格式（默认 csv；arrow 为 Arrow IPC / Feather v2 文件）\n"
+        "  --compress <gzip|zstd>\n"
+        "                      压缩输出为 .gz / .zst（各块在多个线程上并行压缩，标准工具可直接解压）；\n"
+        "                      --merge 的文件名以 .gz / .zst 结尾时也会压缩\n"
+        "  --encoding <native|utf8|utf8-bom>\n"
+        "                      CSV 编码（默认 native：Windows 下为 ANSI，其他平台为 UTF-8）\n"
+        "  --layout <文件>     从 JSON / INI 文件读取记录布局（键名同 GUI.py，默认为控制器布局）\n"
+        "  --from <时间>       只输出该时间及之后的行（YYYY-MM-DD[ hh:mm[:ss]]）\n"
+        "  --to <时间>         只输出该时间之前的行（不含该时刻）。没有有效的 <bin>.bidx 时\n"
+        "                      先读一遍整个文件的时间字并写出该索引，之后的查询只读相关的块\n"
+        "  --columns <列表>    只输出这些通道，逗号分隔的序号（1-13）或表头中的通道名\n"
+        "  --aggregate <窗口[:统计量]>\n"
+        "                      按时间窗口聚合，每个窗口输出一行（时间为窗口起点）；窗口如 10s、1m、\n"
+        "                      1h、1d（须整除一天），统计量为 mean（默认）、min、max 或 last\n"
+        "  --index             整文件转换时也建立 bin 旁的块时间索引 <bin>.bidx；\n"
+        "                      --merge 时按索引排列输入、略过范围外的文件\n"
+        "  --stats             转换后输出各阶段耗时与计数（读取、解码、排序去重、格式化、压缩、写出）\n"
+        "  --stats-json <文件> 将各阶段统计写为 JSON\n"
+        "  --trace <文件>      将各阶段计时区间写为 Chrome trace（chrome://tracing、Perfetto）\n"
+        "  -q, --quiet         不输出汇总信息，只报告错误\n"
+        "  -h, --help          显示本帮助\n"
+        "\n"
+        "退出码: 0 全部成功，1 有文件失败，2 参数错误，130 被中断\n",
+        out);
+}
+
+// 文件名通配符匹配，仅支持 * 与 ?
+static bool matchWildcard(const char *pattern, const char *name)
+{
+    const char *star = nullptr;
+    const char *resume = nullptr;
+    while (*name) {
+        if (*pattern == '?' || (*pattern != '*' && *pattern == *name)) {
+            ++pattern;
+            ++name;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = name;
+        } else if (star) {
+            pattern = star + 1;
+            name = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return *pattern == '\0';
+}
+
+static std::string lowerFilename(const fs::path &path)
+{
+    std::string name = path.filename().string();
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    return name;
+}
+
+static bool endsWith(const std::string &text, const std::string &suffix)
+{
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// .bin 以及压缩后的 .bin.gz / .bin.zst
+static bool hasBinExtension(const fs::path &path)
+{
+    std::string name = lowerFilename(path);
+    return endsWith(name, ".bin") || endsWith(name, ".bin.gz") || endsWith(name, ".bin.zst");
+}
+
+static bool isZipArchive(const fs::path &path)
+{
+    return endsWith(lowerFilename(path), ".zip");
+}
+
+// 展开 zip 压缩包中的 .bin；无法读取时报告并返回 false
+static bool expandZip(const std::string &archive, std::vector<std::string> &files)
+{
+    try {
+        std::vector<std::string> entries = listZipBinEntries(archive);
+        files.insert(files.end(), entries.begin(), entries.end());
+        return true;
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "bint-cli: %s\n", e.what());
+        return false;
+    }
+}
+
+template <typename Iterator>
+static void collectBinFiles(Iterator it, std::vector<std::string> &files)
+{
+    std::error_code ec;
+    std::vector<std::string> archives;
+    for (const fs::directory_entry &entry : it) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        if (hasBinExtension(entry.path())) {
+            files.push_back(entry.path().string());
+        } else if (isZipArchive(entry.path())) {
+            archives.push_back(entry.path().string());
+        }
+    }
+    // 压缩包排在普通文件之后，包内保持原有顺序
+    std::sort(files.begin(), files.end());
+    std::sort(archives.begin(), archives.end());
+    for (const std::string &archive : archives) {
+        expandZip(archive, files);
+    }
+}
+
+// 展开一个命令行输入；没有匹配到任何文件时返回 false
+static bool expandInput(const std::string &arg, bool recursive, std::vector<std::string> &files)
+{
+    std::error_code ec;
+    size_t before = files.size();
+
+    if (arg == "-" || inputKindForPath(arg) == InputKind::ZipEntry) {
+        files.push_back(arg);
+    } else if (arg.find_first_of("*?") != std::string::npos) {
+        fs::path pattern(arg);
+        fs::path dir = pattern.parent_path();
+        std::string name = pattern.filename().string();
+        std::vector<std::string> matched;
+        for (const fs::directory_entry &entry
+                 : fs::directory_iterator(dir.empty() ? fs::path(".") : dir, ec)) {
+            std::string entryName = entry.path().filename().string();
+            if (entry.is_regular_file(ec) && matchWildcard(name.c_str(), entryName.c_str())) {
+                matched.push_back((dir / entryName).string());
+            }
+        }
+        std::sort(matched.begin(), matched.end());
+        for (const std::string &path : matched) {
+            if (isZipArchive(path)) {
+                expandZip(path, files);
+            } else {
+                files.push_back(path);
+            }
+        }
+    } else if (fs::is_directory(arg, ec)) {
+        std::vector<std::string> found;
+        if (recursive) {
+            collectBinFiles(fs::recursive_directory_iterator(arg, ec), found);
+        } else {
+            collectBinFiles(fs::directory_iterator(arg, ec), found);
+        }
+        files.insert(files.end(), found.begin(), found.end());
+    } else if (isZipArchive(arg) && fs::is_regular_file(arg, ec)) {
+        expandZip(arg, files);
+    } else if (fs::exists(arg, ec)) {
+        files.push_back(arg);
+    }
+    return files.size() > before;
+}
+
+// 输出文件存在且不早于输入时视为已转换；zip 项按压缩包的修改时间，标准输入总要转换
+static bool isUpToDate(const std::string &input, const std::string &output)
+{
+    std::error_code ec;
+    fs::file_time_type outputTime = fs::last_write_time(output, ec);
+    if (ec) {
+        return false;
+    }
+    if (inputKindForPath(input) == InputKind::Stdin) {
+        return false;
+    }
+    std::string archive, entry;
+    const std::string &source = splitZipEntryPath(input, archive, entry) ? archive : input;
+    fs::file_time_type inputTime = fs::last_write_time(source, ec);
+    return !ec && outputTime >= inputTime;
+}
+
+static void printErrors(const ConversionReport &report)
+{
+    for (const ConversionError &error : report.errors) {
+        std::fprintf(stderr, "bint-cli: %s：%s\n", error.binPath.c_str(), error.message.c_str());
+    }
+}
+
+// 监视模式：目录中的 bin 文件写完后即转换，直到收到 SIGINT / SIGTERM。
+// 线程池在各批之间复用，新文件到达时不必重新启动
+static int runWatch(const std::vector<std::string> &dirs, bool recursive,
+                    std::chrono::milliseconds settle, bool merge, const std::string &mergedCsv,
+                    const ConversionOptions &options, unsigned jobs, bool quiet)
+{
+    ConversionScheduler scheduler(jobs);
+    FolderWatcher watcher(dirs, recursive, settle);
+    if (!quiet) {
+        std::fprintf(stderr, "正在监视 %zu 个目录，按 Ctrl+C 停止\n", dirs.size());
+    }
+
+    size_t failures = 0;
+    while (true) {
+        std::vector<std::string> ready = watcher.waitReady(options.cancel);
+        if (ready.empty()) {
+            break;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::string> batch;
+        ConversionReport report;
+        if (merge) {
+            // 合并输出包含所有已写完的文件，其中任一比输出新就整体重新合并
+            batch = watcher.knownFiles();
+            bool stale = std::any_of(batch.begin(), batch.end(), [&](const std::string &path){
+                return !isUpToDate(path, mergedCsv);
+            });
+            if (!stale) {
+                continue;
+            }
+            report = scheduler.convertMerged(batch, mergedCsv, options);
+        } else {
+            for (const std::string &path : ready) {
+                if (options.incremental ||
+                    !isUpToDate(path, outputPathForBin(path, options.outputDir, options.format,
+                                                       options.compression))) {
+                    batch.push_back(path);
+                }
+            }
+            if (batch.empty()) {
+                continue;
+            }
+            report = scheduler.convertSeparate(batch, options);
+        }
+
+        printErrors(report);
+        failures += report.errors.size();
+        if (report.cancelled) {
+            std::fputs("bint-cli: 已中断\n", stderr);
+            return 130;
+        }
+        if (!quiet) {
+            double seconds = std::chrono::duration<double>(
+                    std::chrono::steady_clock::now() - start).count();
+            char clock[16];
+            std::time_t now = std::time(nullptr);
+            std::strftime(clock, sizeof(clock), "%H:%M:%S", std::localtime(&now));
+            std::fprintf(stderr, "[%s] %zu 个输入文件，生成 %zu 个文件，%zu 个失败，耗时 %.2f 秒\n",
+                         clock, batch.size(), report.csvFiles.size(), report.errors.size(), seconds);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+static bool parseFormat(const char *name, OutputFormat &format)
+{
+    if (std::strcmp(name, "csv") == 0) {
+        format = OutputFormat::Csv;
+    } else if (std::strcmp(name, "arrow") == 0 || std::strcmp(name, "feather") == 0) {
+        format = OutputFormat::Arrow;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parseCompression(const char *name, OutputCompression &compression)
+{
+    if (std::strcmp(name, "none") == 0) {
+        compression = OutputCompression::None;
+    } else if (std::strcmp(name, "gzip") == 0 || std::strcmp(name, "gz") == 0) {
+        compression = OutputCompression::Gzip;
+    } else if (std::strcmp(name, "zstd") == 0 || std::strcmp(name, "zst") == 0) {
+        compression = OutputCompression::Zstd;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bool parseEncoding(const char *name, CsvEncoding &encoding)
+{
+    if (std::strcmp(name, "native") == 0) {
+        encoding = CsvEncoding::Native;
+    } else if (std::strcmp(name, "utf8") == 0) {
+        encoding = CsvEncoding::Utf8;
+    } else if (std::strcmp(name, "utf8-bom") == 0) {
+        encoding = CsvEncoding::Utf8Bom;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool merge = false;
+    bool recursive = false;
+    bool watch = false;
+    std::chrono::milliseconds settle(300);
+    bool quiet = false;
+    bool stats = false;
+    std::string statsJson;
+    std::string tracePath;
+    unsigned jobs = 0;
+    std::string mergedCsv;
+    std::vector<std::string> inputs;
+    ConversionOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        // 需要参数的选项
+        auto value = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "bint-cli: %s 缺少参数\n", arg);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            printUsage(stdout);
+            return 0;
+        } else if (std::strcmp(arg, "--separate") == 0) {
+            merge = false;
+        } else if (std::strcmp(arg, "--merge") == 0) {
+            merge = true;
+            mergedCsv = value();
+        } else if (std::strcmp(arg, "-o") == 0 || std::strcmp(arg, "--output-dir") == 0) {
+            options.outputDir = value();
+        } else if (std::strcmp(arg, "-j") == 0 || std::strcmp(arg, "--jobs") == 0) {
+            const char *text = value();
+            char *end = nullptr;
+            long n = std::strtol(text, &end, 10);
+            if (*end != '\0' || n < 1 || n > 1024) {
+                std::fprintf(stderr, "bint-cli: 无效的线程数：%s\n", text);
+                return 2;
+            }
+            jobs = static_cast<unsigned>(n);
+        } else if (std::strcmp(arg, "-r") == 0 || std::strcmp(arg, "--recursive") == 0) {
+            recursive = true;
+        } else if (std::strcmp(arg, "--watch") == 0) {
+            watch = true;
+        } else if (std::strcmp(arg, "--settle") == 0) {
+            const char *text = value();
+            char *end = nullptr;
+            long ms = std::strtol(text, &end, 10);
+            if (*end != '\0' || ms < 0 || ms > 3600 * 1000) {
+                std::fprintf(stderr, "bint-cli: 无效的等待时间：%s\n", text);
+                return 2;
+            }
+            settle = std::chrono::milliseconds(ms);
+        } else if (std::strcmp(arg, "--incremental") == 0) {
+            options.incremental = true;
+        } else if (std::strcmp(arg, "--stream") == 0) {
+            options.streaming = true;
+        } else if (std::strcmp(arg, "--memory") == 0) {
+            const char *text = value();
+            char *end = nullptr;
+            long long mb = std::strtoll(text, &end, 10);
+            if (*end != '\0' || mb < 0 || mb > (1LL << 30)) {
+                std::fprintf(stderr, "bint-cli: 无效的内存大小：%s\n", text);
+                return 2;
+            }
+            options.memoryBudget = (uint64_t)mb << 20;
+        } else if (std::strcmp(arg, "--temp-dir") == 0) {
+            options.tempDir = value();
+        } else if (std::strcmp(arg, "--cache") == 0) {
+            options.cacheDir = value();
+        } else if (std::strcmp(arg, "--cache-size") == 0) {
+            const char *text = value();
+            char *end = nullptr;
+            long long mb = std::strtoll(text, &end, 10);
+            if (*end != '\0' || mb < 0 || mb > (1LL << 30)) {
+                std::fprintf(stderr, "bint-cli: 无效的缓存大小：%s\n", text);
+                return 2;
+            }
+            options.cacheMaxBytes = (uint64_t)mb << 20;
+        } else if (std::strcmp(arg, "--format") == 0) {
+            const char *name = value();
+            if (!parseFormat(name, options.format)) {
+                std::fprintf(stderr, "bint-cli: 未知输出格式：%s\n", name);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--compress") == 0) {
+            const char *name = value();
+            if (!parseCompression(name, options.compression)) {
+                std::fprintf(stderr, "bint-cli: 未知压缩方式：%s\n", name);
+                return 2;
+            }
+            if (!compressionAvailable(options.compression)) {
+                std::fprintf(stderr, "bint-cli: 本程序构建时未带 %s 支持\n", name);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--encoding") == 0) {
+            const char *name = value();
+            if (!parseEncoding(name, options.encoding)) {
+                std::fprintf(stderr, "bint-cli: 未知编码：%s\n", name);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--layout") == 0) {
+            const char *path = value();
+            try {
+                options.layout = loadRecordLayout(path);
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "bint-cli: %s\n", e.what());
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--from") == 0 || std::strcmp(arg, "--to") == 0 ||
+                   std::strcmp(arg, "--columns") == 0 || std::strcmp(arg, "--aggregate") == 0) {
+            const char *text = value();
+            try {
+                if (std::strcmp(arg, "--from") == 0) {
+                    options.query.begin = parseTimestampText(text);
+                } else if (std::strcmp(arg, "--to") == 0) {
+                    options.query.end = parseTimestampText(text);
+                } else if (std::strcmp(arg, "--aggregate") == 0) {
+                    options.aggregation = parseAggregation(text);
+                } else {
+                    options.query.columnMask = parseColumnList(text);
+                }
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "bint-cli: %s\n", e.what());
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--index") == 0) {
+            options.blockIndex = true;
+        } else if (std::strcmp(arg, "--stats") == 0) {
+            stats = true;
+        } else if (std::strcmp(arg, "--stats-json") == 0) {
+            statsJson = value();
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            tracePath = value();
+        } else if (std::strcmp(arg, "-q") == 0 || std::strcmp(arg, "--quiet") == 0) {
+            quiet = true;
+        } else if (std::strcmp(arg, "--") == 0) {
+            inputs.insert(inputs.end(), argv + i + 1, argv + argc);
+            break;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            std::fprintf(stderr, "bint-cli: 未知选项：%s\n", arg);
+            printUsage(stderr);
+            return 2;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if (inputs.empty()) {
+        printUsage(stderr);
+        return 2;
+    }
+    if (options.incremental && (merge || options.format != OutputFormat::Csv ||
+                                options.compression != OutputCompression::None)) {
+        std::fputs("bint-cli: --incremental 只能用于分别输出不压缩的 CSV\n", stderr);
+        return 2;
+    }
+    if (options.incremental && (options.query.active() || options.aggregation.active())) {
+        std::fputs("bint-cli: --incremental 不能与 --from、--to、--columns、--aggregate 同时使用\n",
+                   stderr);
+        return 2;
+    }
+    if (options.query.begin >= options.query.end) {
+        std::fputs("bint-cli: --from 必须早于 --to\n", stderr);
+        return 2;
+    }
+
+    if (watch) {
+        if (stats || !statsJson.empty() || !tracePath.empty()) {
+            std::fputs("bint-cli: --watch 不能与 --stats、--stats-json、--trace 同时使用\n", stderr);
+            return 2;
+        }
+        for (const std::string &input : inputs) {
+            std::error_code ec;
+            if (!fs::is_directory(input, ec)) {
+                std::fprintf(stderr, "bint-cli: --watch 的输入必须是目录：%s\n", input.c_str());
+                return 2;
+            }
+        }
+    }
+
+    if (stats || !statsJson.empty() || !tracePath.empty()) {
+        resetPerfStats();
+        setPerfStatsEnabled(true, !tracePath.empty());
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    if (!options.outputDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(options.outputDir, ec);
+        if (ec) {
+            std::fprintf(stderr, "bint-cli: 无法创建输出目录：%s\n", options.outputDir.c_str());
+            return 1;
+        }
+    }
+
+    if (merge && !options.outputDir.empty() && fs::path(mergedCsv).is_relative()) {
+        mergedCsv = (fs::path(options.outputDir) / mergedCsv).string();
+    }
+    // 合并输出按文件名后缀压缩，--compress 时补上后缀
+    if (merge && options.compression != OutputCompression::None &&
+        compressionForPath(mergedCsv) != options.compression) {
+        mergedCsv += compressionExtension(options.compression);
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    options.cancel = &g_cancel;
+
+    if (watch) {
+        return runWatch(inputs, recursive, settle, merge, mergedCsv, options, jobs, quiet);
+    }
+
+    // 展开输入并去重，保持命令行顺序
+    std::vector<std::string> binPaths;
+    size_t failures = 0;
+    for (const std::string &input : inputs) {
+        if (!expandInput(input, recursive, binPaths)) {
+            std::fprintf(stderr, "bint-cli: 未找到匹配的文件：%s\n", input.c_str());
+            ++failures;
+        }
+    }
+    {
+        std::set<std::string> seen;
+        std::vector<std::string> unique;
+        unique.reserve(binPaths.size());
+        for (std::string &path : binPaths) {
+            if (seen.insert(fs::path(path).lexically_normal().string()).second) {
+                unique.push_back(std::move(path));
+            }
+        }
+        binPaths.swap(unique);
+    }
+
+    // 分别输出到同一目录时，不同目录下的同名文件会互相覆盖，提前拒绝
+    if (!merge && !options.outputDir.empty()) {
+        std::set<std::string> outputs;
+        std::vector<std::string> kept;
+        kept.reserve(binPaths.size());
+        for (std::string &path : binPaths) {
+            if (outputs.insert(outputPathForBin(path, options.outputDir, options.format,
+                                                options.compression)).second) {
+                kept.push_back(std::move(path));
+            } else {
+                std::fprintf(stderr, "bint-cli: %s：输出文件与前面的文件重名，已跳过\n", path.c_str());
+                ++failures;
+            }
+        }
+        binPaths.swap(kept);
+    }
+
+    ConversionScheduler scheduler(jobs);
+    ConversionReport report;
+    if (binPaths.empty()) {
+        // 没有可转换的文件
+    } else if (merge) {
+        report = scheduler.convertMerged(binPaths, mergedCsv, options);
+    } else {
+        report = scheduler.convertSeparate(binPaths, options);
+    }
+
+    printErrors(report);
+    failures += report.errors.size();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!quiet) {
+        std::fprintf(stderr, "%zu 个输入文件，生成 %zu 个文件，%zu 个失败，耗时 %.2f 秒\n",
+                     binPaths.size(), report.csvFiles.size(), failures, seconds);
+        if (report.cached > 0) {
+            std::fprintf(stderr, "其中 %zu 个输入文件命中缓存，未重新解析\n", report.cached);
+        }
+    }
+    if (perfStatsEnabled()) {
+        setPerfStatsEnabled(false);
+        PerfSnapshot snapshot = perfSnapshot();
+        if (stats) {
+            std::fputs(formatPerfSummary(snapshot, seconds).c_str(), stderr);
+        }
+        try {
+            if (!statsJson.empty()) {
+                writePerfJson(statsJson, snapshot, seconds);
+            }
+            if (!tracePath.empty()) {
+                writeChromeTrace(tracePath);
+            }
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "bint-cli: %s\n", e.what());
+            ++failures;
+        }
+    }
+
+    if (report.cancelled) {
+        std::fputs("bint-cli: 已中断\n", stderr);
+        return 130;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+// bint-gen：生成合成 bin 文件，供基准测试和排查解析问题使用
+
+#include "bingen.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+static void printUsage(FILE *out)
+{
+    std::fputs(
+        "用法: bint-gen [选项] <输出文件>\n"
+        "\n"
+        "按记录布局生成模拟控制器数据的 .bin 文件，相同参数生成的文件逐字节相同。\n"
+        "\n"
+        "选项:\n"
+        "  -s, --size <大小>   目标大小，可带 K/M/G 后缀（默认 1M）\n"
+        "  --seed <N>          随机种子（默认 1）\n"
+        "  --corrupt <比例>    时间非法的组占比（默认 0.01）\n"
+        "  --duplicate <比例>  重复时间戳的组占比（默认 0.005）\n"
+        "  --swap <比例>       相邻两条时间戳对调的比例，使输入无序（默认 0）\n"
+        "  --blank <比例>      成段的全 0x00 / 0xFF 空白块占比，小于 1（默认 0）\n"
+        "  --tail <字节>       末尾追加不足一块的字节数（默认 0）\n"
+        "  --displace <块数>   把中部连续的这么多块移到末尾，模拟时钟回拨（默认 0）\n"
+        "  --layout <文件>     记录布局文件，格式同 bint-cli --layout\n"
+        "  -q, --quiet         不输出统计信息\n"
+        "  -h, --help          显示本帮助\n",
+        out);
+}
+
+// 带 K/M/G 后缀的字节数
+static bool parseSize(const char *text, uint64_t &bytes)
+{
+    char *end = nullptr;
+    unsigned long long v = std::strtoull(text, &end, 10);
+    if (end == text || text[0] == '-') {
+        return false;
+    }
+    int shift = 0;
+    if (*end == 'K' || *end == 'k') {
+        shift = 10;
+    } else if (*end == 'M' || *end == 'm') {
+        shift = 20;
+    } else if (*end == 'G' || *end == 'g') {
+        shift = 30;
+    }
+    if (shift) {
+        ++end;
+    }
+    if (*end != '\0' || v > (UINT64_MAX >> shift)) {
+        return false;
+    }
+    bytes = (uint64_t)v << shift;
+    return true;
+}
+
+static bool parseRatio(const char *text, double &ratio)
+{
+    char *end = nullptr;
+    double v = std::strtod(text, &end);
+    if (end == text || *end != '\0' || !(v >= 0.0 && v <= 1.0)) {
+        return false;
+    }
+    ratio = v;
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    BinGenOptions options;
+    bool quiet = false;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        auto value = [&]() -> const char * {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "bint-gen: %s 缺少参数\n", arg);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        auto ratio = [&](double &out) {
+            const char *text = value();
+            if (!parseRatio(text, out)) {
+                std::fprintf(stderr, "bint-gen: %s 需要 0 到 1 之间的比例：%s\n", arg, text);
+                std::exit(2);
+            }
+        };
+
+        if (std::strcmp(arg, "-h") == 0 || std::strcmp(arg, "--help") == 0) {
+            printUsage(stdout);
+            return 0;
+        } else if (std::strcmp(arg, "-s") == 0 || std::strcmp(arg, "--size") == 0) {
+            const char *text = value();
+            if (!parseSize(text, options.bytes)) {
+                std::fprintf(stderr, "bint-gen: 无效的大小：%s\n", text);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = std::strtoull(value(), nullptr, 10);
+        } else if (std::strcmp(arg, "--corrupt") == 0) {
+            ratio(options.corruptRatio);
+        } else if (std::strcmp(arg, "--duplicate") == 0) {
+            ratio(options.duplicateRatio);
+        } else if (std::strcmp(arg, "--swap") == 0) {
+            ratio(options.swapRatio);
+        } else if (std::strcmp(arg, "--blank") == 0) {
+            ratio(options.blankRatio);
+            if (options.blankRatio >= 1.0) {
+                std::fputs("bint-gen: --blank 必须小于 1\n", stderr);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--tail") == 0) {
+            const char *text = value();
+            uint64_t tail;
+            if (!parseSize(text, tail) || tail > (1 << 20)) {
+                std::fprintf(stderr, "bint-gen: 无效的字节数：%s\n", text);
+                return 2;
+            }
+            options.tailBytes = (size_t)tail;
+        } else if (std::strcmp(arg, "--displace") == 0) {
+            options.displacedBlocks = std::strtoull(value(), nullptr, 10);
+        } else if (std::strcmp(arg, "--layout") == 0) {
+            const char *path = value();
+            try {
+                options.layout = loadRecordLayout(path);
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "bint-gen: %s\n", e.what());
+                return 2;
+            }
+        } else if (std::strcmp(arg, "-q") == 0 || std::strcmp(arg, "--quiet") == 0) {
+            quiet = true;
+        } else if (arg[0] == '-' && arg[1] != '\0') {
+            std::fprintf(stderr, "bint-gen: 未知选项：%s\n", arg);
+            printUsage(stderr);
+            return 2;
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            std::fputs("bint-gen: 只能指定一个输出文件\n", stderr);
+            return 2;
+        }
+    }
+    if (output.empty()) {
+        printUsage(stderr);
+        return 2;
+    }
+    if (options.tailBytes >= options.layout.subsequentBlockSize) {
+        std::fputs("bint-gen: --tail 必须小于一块\n", stderr);
+        return 2;
+    }
+    if (options.corruptRatio + options.duplicateRatio > 1.0) {
+        std::fputs("bint-gen: --corrupt 与 --duplicate 之和不能超过 1\n", stderr);
+        return 2;
+    }
+
+    BinGenStats stats;
+    try {
+        stats = generateBinFile(output, options);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "bint-gen: %s\n", e.what());
+        return 1;
+    }
+    if (!quiet) {
+        std::fprintf(stderr,
+                     "%s：%" PRIu64 " 字节，%" PRIu64 " 组，有效 %" PRIu64 " 行，去重后 %" PRIu64
+                     " 行，空白块 %" PRIu64 "\n",
+                     output.c_str(), stats.bytes, stats.groups, stats.validGroups, stats.uniqueRows,
+                     stats.blankBlocks);
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "blockindex.h"
+#include "inputsource.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+static const char kIndexMagic[] = "bint-index 1";
+
+void BlockIndex::findBlocks(uint64_t begin, uint64_t end, size_t &first, size_t &last) const
+{
+    first = last = 0;
+    bool found = false;
+    for (size_t k = 0; k < entries.size(); ++k) {
+        const BlockIndexEntry &e = entries[k];
+        if (e.empty() || e.minTimestamp >= end || e.maxTimestamp < begin) {
+            continue;
+        }
+        if (!found) {
+            first = (size_t)(k * entryBlocks);
+            found = true;
+        }
+        last = (size_t)std::min<uint64_t>((k + 1) * entryBlocks, blockCount);
+    }
+}
+
+std::string blockIndexPathFor(const std::string &binFilename)
+{
+    return binFilename + ".bidx";
+}
+
+bool readBlockIndex(const std::string &path, BlockIndex &index)
+{
+    FILE *fp = std::fopen(path.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char line[256];
+    bool ok = std::fgets(line, sizeof(line), fp) &&
+              std::strncmp(line, kIndexMagic, sizeof(kIndexMagic) - 1) == 0;
+    unsigned seen = 0;
+    uint64_t entryCount = 0;
+    BlockIndex x;
+    // 键值行，到 entries= 为止
+    while (ok && seen != 255 && std::fgets(line, sizeof(line), fp)) {
+        uint64_t u;
+        int64_t i;
+        if (std::sscanf(line, "input_size=%" SCNu64, &u) == 1) {
+            x.inputSize = u;
+            seen |= 1;
+        } else if (std::sscanf(line, "input_mtime=%" SCNd64, &i) == 1) {
+            x.inputMtime = i;
+            seen |= 2;
+        } else if (std::strncmp(line, "layout=", 7) == 0) {
+            x.layout = line + 7;
+            x.layout.erase(x.layout.find_last_not_of("\r\n") + 1);
+            seen |= 4;
+        } else if (std::sscanf(line, "entry_blocks=%" SCNu64, &u) == 1 && u > 0) {
+            x.entryBlocks = u;
+            seen |= 8;
+        } else if (std::sscanf(line, "block_count=%" SCNu64, &u) == 1) {
+            x.blockCount = u;
+            seen |= 16;
+        } else if (std::sscanf(line, "min_timestamp=%" SCNx64, &u) == 1) {
+            x.minTimestamp = u;
+            seen |= 32;
+        } else if (std::sscanf(line, "max_timestamp=%" SCNx64, &u) == 1) {
+            x.maxTimestamp = u;
+            seen |= 64;
+        } else if (std::sscanf(line, "entries=%" SCNu64, &u) == 1) {
+            entryCount = u;
+            seen |= 128;
+        } else {
+            ok = false;
+        }
+    }
+    ok = ok && seen == 255 && entryCount == (x.blockCount + x.entryBlocks - 1) / x.entryBlocks;
+    if (ok) {
+        x.entries.resize((size_t)entryCount);
+    }
+    for (size_t k = 0; ok && k < x.entries.size(); ++k) {
+        BlockIndexEntry &e = x.entries[k];
+        ok = std::fgets(line, sizeof(line), fp) &&
+             std::sscanf(line, "%" SCNu64 " %" SCNx64 " %" SCNx64,
+                         &e.offset, &e.minTimestamp, &e.maxTimestamp) == 3;
+    }
+    std::fclose(fp);
+    if (!ok) {
+        return false;
+    }
+    index = std::move(x);
+    return true;
+}
+
+void writeBlockIndex(const std::string &path, const BlockIndex &x)
+{
+    std::string tmp = path + ".tmp";
+    FILE *fp = std::fopen(tmp.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("无法写索引文件：" + tmp);
+    }
+    int n = std::fprintf(fp,
+                         "%s\n"
+                         "input_size=%" PRIu64 "\n"
+                         "input_mtime=%" PRId64 "\n"
+                         "layout=%s\n"
+                         "entry_blocks=%" PRIu64 "\n"
+                         "block_count=%" PRIu64 "\n"
+                         "min_timestamp=%" PRIx64 "\n"
+                         "max_timestamp=%" PRIx64 "\n"
+                         "entries=%zu\n",
+                         kIndexMagic, x.inputSize, x.inputMtime, x.layout.c_str(), x.entryBlocks,
+                         x.blockCount, x.minTimestamp, x.maxTimestamp, x.entries.size());
+    for (size_t k = 0; k < x.entries.size() && n >= 0; ++k) {
+        const BlockIndexEntry &e = x.entries[k];
+        n = std::fprintf(fp, "%" PRIu64 " %" PRIx64 " %" PRIx64 "\n",
+                         e.offset, e.minTimestamp, e.maxTimestamp);
+    }
+    if (std::fclose(fp) != 0 || n < 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("无法写索引文件：" + tmp);
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("无法写索引文件：" + path);
+    }
+}
+
+bool binFileStamp(const std::string &binFilename, uint64_t &size, int64_t &mtime)
+{
+    if (inputKindForPath(binFilename) != InputKind::File) {
+        return false;
+    }
+    std::error_code ec;
+    size = fs::file_size(binFilename, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = (int64_t)fs::last_write_time(binFilename, ec).time_since_epoch().count();
+    return !ec;
+}
+
+bool loadBlockIndex(const std::string &binFilename, const RecordLayout &layout,
+                    BlockIndex &index)
+{
+    uint64_t size;
+    int64_t mtime;
+    BlockIndex x;
+    if (!binFileStamp(binFilename, size, mtime) ||
+        !readBlockIndex(blockIndexPathFor(binFilename), x) ||
+        x.inputSize != size || x.inputMtime != mtime || x.layout != layout.toString()) {
+        return false;
+    }
+    index = std::move(x);
+    return true;
+}
+
+bool orderByBlockIndex(std::vector<std::string> &binPaths, const RecordLayout &layout,
+                       uint64_t begin, uint64_t end)
+{
+    struct Item {
+        std::string path;
+        uint64_t minTimestamp;
+        uint64_t maxTimestamp;
+    };
+    std::vector<Item> items;
+    items.reserve(binPaths.size());
+    for (const std::string &path : binPaths) {
+        BlockIndex index;
+        if (!loadBlockIndex(path, layout, index)) {
+            return false;
+        }
+        if (index.overlaps(begin, end)) {
+            items.push_back(Item{ path, index.minTimestamp, index.maxTimestamp });
+        }
+    }
+
+    // 按最早时间稳定排序，相邻文件严格不重叠时才采用
+    std::vector<Item> sorted = items;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Item &a, const Item &b){
+        return a.minTimestamp < b.minTimestamp;
+    });
+    bool disjoint = true;
+    for (size_t i = 1; i < sorted.size() && disjoint; ++i) {
+        disjoint = sorted[i - 1].maxTimestamp < sorted[i].minTimestamp;
+    }
+    const std::vector<Item> &kept = disjoint ? sorted : items;
+
+    binPaths.clear();
+    for (const Item &item : kept) {
+        binPaths.push_back(item.path);
+    }
+    return true;
+}
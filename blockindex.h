@@ -0,0 +1,82 @@
+#ifndef BLOCKINDEX_H
+#define BLOCKINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "recordlayout.h"
+
+/// 每个索引项覆盖的块数（默认布局为 128KB）
+static const size_t kIndexEntryBlocks = 1024;
+
+/// 一段连续块的时间范围
+struct BlockIndexEntry {
+    uint64_t offset = 0;                ///< 第一个块在文件中的偏移
+    uint64_t minTimestamp = UINT64_MAX; ///< 段内最早的打包时间戳，没有合法行时为 UINT64_MAX
+    uint64_t maxTimestamp = 0;          ///< 段内最晚的打包时间戳，没有合法行时为0
+
+    bool empty() const { return minTimestamp > maxTimestamp; }
+};
+
+/**
+ * @brief BlockIndex
+ *  bin 文件的块级时间索引，放在 bin 文件旁（见 blockIndexPathFor）。
+ *  块序列（见 BinBlockReader）每 entryBlocks 个块一项，记录偏移与时间范围；
+ *  按文件大小、修改时间与记录布局判断是否仍然有效。
+ *  各项的范围是精确值，输入无序时同样可用。
+ */
+struct BlockIndex {
+    uint64_t inputSize = 0;             ///< 建立索引时文件大小
+    int64_t inputMtime = 0;             ///< 建立索引时文件修改时间（仅比较是否相同）
+    std::string layout = RecordLayout().toString(); ///< 记录布局（RecordLayout::toString）
+    uint64_t entryBlocks = kIndexEntryBlocks;
+    uint64_t blockCount = 0;            ///< 块序列的块数
+    uint64_t minTimestamp = UINT64_MAX; ///< 全文件（含单独的首块）最早的时间戳
+    uint64_t maxTimestamp = 0;          ///< 全文件最晚的时间戳
+    std::vector<BlockIndexEntry> entries;
+
+    bool empty() const { return minTimestamp > maxTimestamp; }
+    /// 全文件是否有落在 [begin, end) 内的可能
+    bool overlaps(uint64_t begin, uint64_t end) const
+    {
+        return !empty() && minTimestamp < end && maxTimestamp >= begin;
+    }
+
+    /// 含有 [begin, end) 内时间戳的第一个块到最后一个块，即块区间 [first, last)；
+    /// 没有时 first == last
+    void findBlocks(uint64_t begin, uint64_t end, size_t &first, size_t &last) const;
+};
+
+/// bin 文件对应的索引文件路径
+std::string blockIndexPathFor(const std::string &binFilename);
+
+/// 读取索引文件，不存在或格式不对时返回 false
+bool readBlockIndex(const std::string &path, BlockIndex &index);
+
+/// 写索引文件（先写临时文件再改名），失败时抛出 std::runtime_error
+void writeBlockIndex(const std::string &path, const BlockIndex &index);
+
+/// 文件当前的大小与修改时间，无法获取时返回 false。
+/// 压缩输入、zip 项与标准输入不能按偏移定位，同样返回 false（不建立、不使用索引）
+bool binFileStamp(const std::string &binFilename, uint64_t &size, int64_t &mtime);
+
+/**
+ * @brief loadBlockIndex
+ *  读取 bin 文件旁的索引，且索引与文件当前的大小、修改时间和 layout 一致时返回 true。
+ */
+bool loadBlockIndex(const std::string &binFilename, const RecordLayout &layout,
+                    BlockIndex &index);
+
+/**
+ * @brief orderByBlockIndex
+ *  合并输出前按索引整理输入，不打开 bin 文件：去掉没有 [begin, end) 内数据的文件；
+ *  其余文件的时间范围互不重叠时按时间先后排列，使流式合并保持有序、不必外部排序。
+ *  结果与原顺序合并相同（范围不重叠即没有跨文件的重复时间戳）。
+ *  任一文件没有有效索引时不做任何改动，返回 false。
+ */
+bool orderByBlockIndex(std::vector<std::string> &binPaths, const RecordLayout &layout,
+                       uint64_t begin = 0, uint64_t end = UINT64_MAX);
+
+#endif // BLOCKINDEX_H
@@ -0,0 +1,470 @@
+#include "converter.h"
+#include "parsebin.h"
+#include "blockindex.h"
+#include "spillrun.h"
+#include "inputsource.h"
+#include "resultcache.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+
+// 分段落盘时每次解析的块数与每段的最少行数
+static const size_t kSpillBatchBlocks = 16384;
+static const size_t kMinRunRows = 1 << 16;
+// 缓存段的格式版本：RunWriter 的行格式改变时递增，旧的缓存随之失效
+static const int kCachedRunVersion = 2;
+
+std::string outputPathForBin(const std::string &inputPath, const std::string &outputDir,
+                             OutputFormat format, OutputCompression compression)
+{
+    // 压缩输入与 zip 项按解压后的文件名；只替换文件名部分的后缀，目录名中的'.'不算
+    std::string binPath = inputBasePath(inputPath);
+    size_t slashPos = binPath.find_last_of("/\\");
+    size_t nameStart = (slashPos == std::string::npos) ? 0 : slashPos + 1;
+    size_t dotPos = binPath.find_last_of('.');
+    std::string stem = (dotPos != std::string::npos && dotPos > nameStart)
+            ? binPath.substr(0, dotPos) : binPath;
+    std::string extension = std::string(outputExtension(format)) + compressionExtension(compression);
+    if (outputDir.empty()) {
+        return stem + extension;
+    }
+    std::string dir = outputDir;
+    if (dir.back() != '/' && dir.back() != '\\') {
+        dir += '/';
+    }
+    return dir + stem.substr(nameStart) + extension;
+}
+
+// 影响解析结果（有序段内容）的选项，作为合并输出缓存键的一部分
+static std::string parseCacheOptions(const ConversionOptions &options)
+{
+    char text[96];
+    std::snprintf(text, sizeof(text), " run%d %" PRIx64 " %" PRIx64 " %x", kCachedRunVersion,
+                  options.query.begin, options.query.end, (unsigned)options.query.columnMask);
+    return options.layout.toString() + text;
+}
+
+// 另加影响输出文件内容的选项，作为分别输出缓存键的一部分
+static std::string outputCacheOptions(const ConversionOptions &options)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), " out%d %d %d %u:%d", (int)options.format,
+                  (int)options.encoding, (int)options.compression,
+                  (unsigned)options.aggregation.windowSeconds, (int)options.aggregation.stat);
+    return parseCacheOptions(options) + text;
+}
+
+// 将每个文件的错误按输入顺序汇总
+static void collectErrors(const std::vector<std::string> &binPaths,
+                          const std::vector<std::string> &messages,
+                          const std::vector<char> &failed,
+                          ConversionReport &report)
+{
+    for (size_t i = 0; i < binPaths.size(); ++i) {
+        if (failed[i]) {
+            report.errors.push_back(ConversionError{ binPaths[i], messages[i] });
+        }
+    }
+}
+
+ConversionScheduler::ConversionScheduler(unsigned threadCount)
+    : m_pool(threadCount)
+    , m_tables(std::max<size_t>(8, m_pool.size() + 1))
+{
+}
+
+ParseOptions ConversionScheduler::parseOptions(const ConversionOptions &options)
+{
+    // 单个大文件也在同一线程池上分段并行解码（文件多时各段由发起线程自行完成）
+    ParseOptions parse;
+    parse.pool = &m_pool;
+    parse.progress = options.progress;
+    parse.cancel = options.cancel;
+    parse.layout = &options.layout;
+    parse.query = &options.query;
+    parse.blockIndex = options.blockIndex;
+    return parse;
+}
+
+StreamOptions ConversionScheduler::streamOptions(const ConversionOptions &options)
+{
+    StreamOptions stream;
+    stream.tablePool = &m_tables;
+    stream.format = options.format;
+    stream.encoding = options.encoding;
+    stream.progress = options.progress;
+    stream.cancel = options.cancel;
+    stream.layout = &options.layout;
+    stream.query = &options.query;
+    stream.aggregation = &options.aggregation;
+    stream.tempDir = options.tempDir;
+    if (options.memoryBudget) {
+        // 段在内存中排序，每行约含时间戳、13列与行号
+        uint64_t rows = options.memoryBudget / (sizeof(uint64_t) + kChannelCount * sizeof(float) +
+                                                sizeof(uint32_t));
+        stream.sortRunRows = (size_t)std::max<uint64_t>(4096, std::min<uint64_t>(stream.sortRunRows, rows));
+    }
+    return stream;
+}
+
+static inline bool isCancelled(const ConversionOptions &options)
+{
+    return options.cancel && options.cancel->load();
+}
+
+// 一行解析结果在内存中的字节数：时间戳、保存的各列，以及排序时的行号
+static uint64_t rowBytesInMemory(const ConversionOptions &options)
+{
+    return sizeof(uint64_t) + columnCount(options.query.columnMask) * sizeof(float) +
+           sizeof(uint32_t);
+}
+
+// 按文件大小估计全部解析到内存所需的字节数（不考虑时间范围；压缩输入按估计的压缩率）
+static uint64_t estimateDecodedBytes(const std::vector<std::string> &binPaths,
+                                     const ConversionOptions &options)
+{
+    const RecordLayout &layout = options.layout;
+    uint64_t rowsPerBlock = layout.subsequentBlockSize / layout.groupBytes();
+    uint64_t rows = 0;
+    for (const std::string &path : binPaths) {
+        rows += (estimatedInputBytes(path) / layout.subsequentBlockSize + 1) * rowsPerBlock;
+    }
+    return rows * rowBytesInMemory(options);
+}
+
+// 分段解析一个文件，每满 runRows 行排序后写成 spill 中的一个有序段，依次追加到 runs
+static void spillBinFile(const std::string &binPath, const ConversionOptions &options,
+                         size_t runRows, RecordTable &table, SpillFiles &spill,
+                         std::vector<std::string> &runs)
+{
+    BinBlockReader reader(binPath, options.layout, options.query);
+    if (options.progress) {
+        // 文件头与时间范围外未读取的块计入进度
+        options.progress(reader.dataOffset() + reader.skippedBytes(), 0);
+    }
+    std::vector<uint32_t> order;
+    auto spillTable = [&]{
+        sortRowOrder(table.timestamps.data(), table.size(), order);
+        runs.push_back(spill.next());
+        RunWriter run(runs.back(), options.query.columnMask);
+        run.write(table, order);
+        run.close();
+        table.clear();
+    };
+    while (true) {
+        if (isCancelled(options)) {
+            throw ParseCancelled();
+        }
+        size_t before = table.size();
+        size_t blocks = reader.decodeNext(table, kSpillBatchBlocks);
+        if (blocks == 0) {
+            break;
+        }
+        if (options.progress) {
+            options.progress(blocks * reader.blockSize(), table.size() - before);
+        }
+        if (table.size() >= runRows) {
+            spillTable();
+        }
+    }
+    if (!table.empty()) {
+        spillTable();
+    }
+}
+
+// 合并输出的实际输入：有索引时去掉范围外的文件并按时间排列，结果不变
+static std::vector<std::string> mergeInputs(const std::vector<std::string> &binPaths,
+                                            const ConversionOptions &options)
+{
+    std::vector<std::string> inputs = binPaths;
+    if (options.blockIndex) {
+        orderByBlockIndex(inputs, options.layout, options.query.begin, options.query.end);
+    }
+    return inputs;
+}
+
+// 写出结果；失败或写完时已被取消则不 close()，输出端丢弃临时文件，
+// 不留下不完整的结果，原有的同名文件保持不变
+template <typename Source>
+static bool writeOutputOrRemove(const std::string &csvFilename, const Source &source,
+                                const ConversionOptions &options)
+{
+    std::unique_ptr<RecordSink> sink = openRecordSink(csvFilename, options.format,
+                                                      options.encoding,
+                                                      options.query.columnMask,
+                                                      &options.aggregation);
+    writeRecords(*sink, source);
+    if (isCancelled(options)) {
+        return false;
+    }
+    sink->close();
+    return true;
+}
+
+ConversionReport ConversionScheduler::convertSeparate(const std::vector<std::string> &binPaths,
+                                                      const ConversionOptions &options)
+{
+    // 状态：0 成功，1 失败，2 取消。非 vector<bool>：各任务并发写不同元素
+    std::vector<std::string> messages(binPaths.size());
+    std::vector<char> failed(binPaths.size(), 0);
+    std::vector<char> cancelled(binPaths.size(), 0);
+    std::vector<char> cached(binPaths.size(), 0);
+    std::vector<std::string> outputs(binPaths.size());
+    ResultCache cache(options.cacheDir);
+    bool useCache = !options.cacheDir.empty() && !options.incremental;
+
+    for (size_t i = 0; i < binPaths.size(); ++i) {
+        m_pool.submit([&, i]{
+            try {
+                outputs[i] = outputPathForBin(binPaths[i], options.outputDir, options.format,
+                                              options.compression);
+                std::string key;
+                bool cacheable = useCache &&
+                                 ResultCache::key(binPaths[i], outputCacheOptions(options), key);
+                if (cacheable && cache.outputMatches(outputs[i], key)) {
+                    cached[i] = true;
+                    return;
+                }
+                if (options.incremental) {
+                    if (options.format != OutputFormat::Csv) {
+                        throw std::runtime_error("增量转换只支持 CSV");
+                    }
+                    if (options.query.active()) {
+                        throw std::runtime_error("增量转换不支持时间范围与列筛选");
+                    }
+                    if (options.compression != OutputCompression::None) {
+                        throw std::runtime_error("增量转换不支持压缩输出");
+                    }
+                    if (options.aggregation.active()) {
+                        throw std::runtime_error("增量转换不支持聚合输出");
+                    }
+                    if (inputKindForPath(binPaths[i]) != InputKind::File) {
+                        throw std::runtime_error("增量转换不支持压缩输入、zip 项与标准输入");
+                    }
+                    AppendOptions append;
+                    append.encoding = options.encoding;
+                    append.progress = options.progress;
+                    append.cancel = options.cancel;
+                    append.layout = &options.layout;
+                    appendBinToCsv(binPaths[i], outputs[i], append);
+                } else if (options.streaming) {
+                    streamBinToCsv({ binPaths[i] }, outputs[i], streamOptions(options));
+                } else {
+                    Recycled<RecordTable> recs(&m_tables);
+                    parseBinFile(binPaths[i], *recs, parseOptions(options));
+                    if (!writeOutputOrRemove(outputs[i], *recs, options)) {
+                        cancelled[i] = true;
+                    }
+                }
+                if (cacheable && !cancelled[i]) {
+                    cache.storeOutput(outputs[i], key);
+                }
+            } catch (const ParseCancelled &) {
+                cancelled[i] = true;
+            } catch (const std::exception &e) {
+                messages[i] = e.what();
+                failed[i] = true;
+            }
+        });
+    }
+    m_pool.wait();
+
+    ConversionReport report;
+    for (size_t i = 0; i < binPaths.size(); ++i) {
+        if (cancelled[i]) {
+            report.cancelled = true;
+        } else if (!failed[i]) {
+            report.csvFiles.push_back(outputs[i]);
+            report.cached += cached[i];
+        }
+    }
+    collectErrors(binPaths, messages, failed, report);
+    return report;
+}
+
+ConversionReport ConversionScheduler::convertMerged(const std::vector<std::string> &allPaths,
+                                                    const std::string &csvFilename,
+                                                    const ConversionOptions &options)
+{
+    if (options.streaming) {
+        return convertMergedStreaming(allPaths, csvFilename, options);
+    }
+    std::vector<std::string> binPaths = mergeInputs(allPaths, options);
+    // 缓存的是各文件的有序段，与分段落盘走同一条路径
+    if (!options.cacheDir.empty() ||
+        (options.memoryBudget && estimateDecodedBytes(binPaths, options) > options.memoryBudget)) {
+        return convertMergedSpilling(binPaths, csvFilename, options);
+    }
+
+    std::vector<std::string> messages(binPaths.size());
+    std::vector<char> failed(binPaths.size(), 0);
+    std::vector<RecordTable> tables(binPaths.size());
+    // 写完（或失败、取消）后各表归还池中
+    struct TablesReturn {
+        RecyclePool<RecordTable> &pool;
+        std::vector<RecordTable> &tables;
+        ~TablesReturn()
+        {
+            for (RecordTable &t : tables) {
+                pool.release(std::move(t));
+            }
+        }
+    } tablesReturn{ m_tables, tables };
+
+    for (size_t i = 0; i < binPaths.size(); ++i) {
+        m_pool.submit([&, i]{
+            try {
+                tables[i] = m_tables.acquire();
+                parseBinFile(binPaths[i], tables[i], parseOptions(options));
+            } catch (const ParseCancelled &) {
+                // 由下面统一检查取消标志
+            } catch (const std::exception &e) {
+                messages[i] = e.what();
+                failed[i] = true;
+            }
+        });
+    }
+    m_pool.wait();
+
+    ConversionReport report;
+    collectErrors(binPaths, messages, failed, report);
+    if (isCancelled(options)) {
+        report.cancelled = true;
+        return report;
+    }
+    if (!report.errors.empty()) {
+        return report;
+    }
+
+    try {
+        if (writeOutputOrRemove(csvFilename, tables, options)) {
+            report.csvFiles.push_back(csvFilename);
+        } else {
+            report.cancelled = true;
+        }
+    } catch (const std::exception &e) {
+        report.errors.push_back(ConversionError{ csvFilename, e.what() });
+    }
+    return report;
+}
+
+ConversionReport ConversionScheduler::convertMergedSpilling(const std::vector<std::string> &binPaths,
+                                                            const std::string &csvFilename,
+                                                            const ConversionOptions &options)
+{
+    // 各文件并行分段解析落盘；同时解析的文件各占一个段的内存，合起来不超过预算。
+    // 不限内存（只为缓存走到这里）时每个文件一段
+    uint64_t taskBudget = options.memoryBudget
+            ? options.memoryBudget / std::max<size_t>(1, m_pool.size()) : UINT64_MAX;
+    size_t runRows = (size_t)std::min<uint64_t>(
+            SIZE_MAX, std::max<uint64_t>(kMinRunRows, taskBudget / rowBytesInMemory(options)));
+
+    // 缓存键先并行算出；内容相同的输入只由第一个读写缓存，避免同时写同一组段
+    ResultCache cache(options.cacheDir, options.cacheMaxBytes);
+    std::vector<std::string> keys(binPaths.size());
+    if (!options.cacheDir.empty()) {
+        for (size_t i = 0; i < binPaths.size(); ++i) {
+            m_pool.submit([&, i]{
+                if (!ResultCache::key(binPaths[i], parseCacheOptions(options), keys[i])) {
+                    keys[i].clear();
+                }
+            });
+        }
+        m_pool.wait();
+        std::set<std::string> seen;
+        for (std::string &key : keys) {
+            if (!key.empty() && !seen.insert(key).second) {
+                key.clear();
+            }
+        }
+    }
+
+    SpillFiles spill(options.tempDir);
+    std::vector<std::vector<std::string>> runs(binPaths.size());
+    std::vector<std::string> messages(binPaths.size());
+    std::vector<char> failed(binPaths.size(), 0);
+    std::vector<char> cached(binPaths.size(), 0);
+    for (size_t i = 0; i < binPaths.size(); ++i) {
+        m_pool.submit([&, i]{
+            try {
+                if (!keys[i].empty() && cache.findRuns(keys[i], runs[i])) {
+                    cached[i] = true;
+                    if (options.progress) {
+                        options.progress(estimatedInputBytes(binPaths[i]), 0);
+                    }
+                    return;
+                }
+                Recycled<RecordTable> table(&m_tables);
+                spillBinFile(binPaths[i], options, runRows, *table, spill, runs[i]);
+                if (!keys[i].empty() && !isCancelled(options)) {
+                    cache.storeRuns(keys[i], binPaths[i], runs[i]);
+                }
+            } catch (const ParseCancelled &) {
+                // 由下面统一检查取消标志
+            } catch (const std::exception &e) {
+                messages[i] = e.what();
+                failed[i] = true;
+            }
+        });
+    }
+    m_pool.wait();
+
+    ConversionReport report;
+    collectErrors(binPaths, messages, failed, report);
+    if (isCancelled(options)) {
+        report.cancelled = true;
+        return report;
+    }
+    if (!report.errors.empty()) {
+        return report;
+    }
+    report.cached = (size_t)std::count(cached.begin(), cached.end(), 1);
+
+    try {
+        // 按文件顺序排列各段：时间戳相同时先输入的文件优先，与内存中归并的结果相同
+        std::vector<std::string> allRuns;
+        for (std::vector<std::string> &fileRuns : runs) {
+            allRuns.insert(allRuns.end(), fileRuns.begin(), fileRuns.end());
+        }
+        reduceRuns(allRuns, spill);
+        std::unique_ptr<RecordSink> sink = openRecordSink(csvFilename, options.format,
+                                                          options.encoding,
+                                                          options.query.columnMask,
+                                                          &options.aggregation);
+        sink->writeHeader();
+        mergeRuns(allRuns, *sink);
+        if (isCancelled(options)) {
+            report.cancelled = true;
+            return report;
+        }
+        sink->close();
+        report.csvFiles.push_back(csvFilename);
+    } catch (const std::exception &e) {
+        report.errors.push_back(ConversionError{ csvFilename, e.what() });
+    }
+    return report;
+}
+
+ConversionReport ConversionScheduler::convertMergedStreaming(const std::vector<std::string> &binPaths,
+                                                             const std::string &csvFilename,
+                                                             const ConversionOptions &options)
+{
+    // 一条流水线顺序读完所有文件，出错时无法区分是哪一个输入，错误记在输出文件上
+    ConversionReport report;
+    try {
+        streamBinToCsv(mergeInputs(binPaths, options), csvFilename, streamOptions(options));
+        report.csvFiles.push_back(csvFilename);
+    } catch (const ParseCancelled &) {
+        report.cancelled = true;
+    } catch (const std::exception &e) {
+        report.errors.push_back(ConversionError{ csvFilename, e.what() });
+    }
+    return report;
+}
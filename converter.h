@@ -0,0 +1,120 @@
+#ifndef CONVERTER_H
+#define CONVERTER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parsebin.h"
+#include "aggregatesink.h"
+#include "streampipeline.h"
+#include "incremental.h"
+#include "outputfile.h"
+#include "recyclepool.h"
+
+/// 合并输出默认可使用的内存
+static const uint64_t kDefaultMemoryBudget = (uint64_t)2 << 30;
+
+/// 单个文件的转换错误
+struct ConversionError {
+    std::string binPath;
+    std::string message;
+};
+
+/// 一批转换的结果，均按输入顺序排列
+struct ConversionReport {
+    std::vector<std::string> csvFiles;      ///< 成功生成的输出文件
+    std::vector<ConversionError> errors;    ///< 失败的文件及原因
+    bool cancelled = false;                 ///< 被取消（被取消的文件不计入 errors）
+    size_t cached = 0;                      ///< 命中结果缓存、未重新解析的输入文件数
+};
+
+/// 转换选项
+struct ConversionOptions {
+    OutputFormat format = OutputFormat::Csv;
+    CsvEncoding encoding = CsvEncoding::Native;     ///< 仅 CSV 输出有效
+    /// 进度回调：新消耗的输入字节数与新解析的行数，会在多个工作线程中并发调用
+    std::function<void(uint64_t bytes, uint64_t rows)> progress;
+    /// 取消标志：置为 true 后尽快停止；未完成的输出文件不会留在磁盘上
+    const std::atomic<bool> *cancel = nullptr;
+    /// 流式转换：边解析边写出，内存占用与文件大小无关（见 streamBinToCsv）。
+    /// 合并输出时所有文件只走一条流水线，不再各自并行解析。
+    bool streaming = false;
+    /// 分别输出时输出文件所在目录，空为与 bin 文件同目录
+    std::string outputDir;
+    /// 增量转换：借助 CSV 旁的断点只解析新增的块并追加（见 appendBinToCsv）。
+    /// 仅对分别输出有效，且只支持 CSV；输入须为普通 .bin 文件（不支持压缩输入、zip 项与标准输入），
+    /// 不满足时该文件报错
+    bool incremental = false;
+    /// bin 文件的记录布局
+    RecordLayout layout;
+    /// 只输出时间范围内的行与选中的列（见 RecordQuery）；不能与增量转换同时使用
+    RecordQuery query;
+    /// 整文件转换时建立 bin 文件旁的块时间索引（见 BlockIndex）。合并输出时先按索引
+    /// 去掉范围外的文件、按时间先后排列输入，不必打开这些文件。
+    /// 时间范围查询总按索引定位、没有时建立，不受此项影响
+    bool blockIndex = false;
+    /// 合并输出可使用的内存（字节），0 为不限。按文件大小估计解析结果超出时，
+    /// 各文件分段解析、段内排序后写成 tempDir 下的临时段，再 k 路归并写出，结果不变。
+    /// 流式转换的外部排序段也不超过此大小
+    uint64_t memoryBudget = kDefaultMemoryBudget;
+    /// 外部排序临时文件所在目录，空为系统临时目录
+    std::string tempDir;
+    /// 分别输出时的压缩方式，输出文件名追加对应后缀（.gz / .zst）；
+    /// 合并输出按输出文件名的后缀决定，不看此项
+    OutputCompression compression = OutputCompression::None;
+    /// 按时间窗口聚合输出（见 AggregateSink），每个窗口一行；不能与增量转换同时使用
+    Aggregation aggregation;
+    /// 结果缓存目录（见 ResultCache），空为不缓存。分别输出时输出未变的文件直接跳过；
+    /// 合并输出（流式除外）时各文件的有序段存入缓存，下次只解析新的文件。增量转换不使用。
+    /// 每个输入文件只保留最新一组段：文件改动后旧的段在存入新段时删除
+    std::string cacheDir;
+    /// 缓存中有序段的总大小上限（字节），0 为不限；超出时删除最久未用的段
+    uint64_t cacheMaxBytes = 0;
+};
+
+/// 分别输出时 bin 文件对应的输出路径（同名，替换为 format 的后缀，压缩时再加上
+/// compression 的后缀）；outputDir 非空时放到该目录下
+std::string outputPathForBin(const std::string &binPath,
+                             const std::string &outputDir = std::string(),
+                             OutputFormat format = OutputFormat::Csv,
+                             OutputCompression compression = OutputCompression::None);
+
+/**
+ * @brief ConversionScheduler
+ *  在线程池上并行转换多个 bin 文件。每个文件的解析（分别输出时连同写CSV）
+ *  是一个独立任务；错误按文件收集到 ConversionReport 中，不中断其他文件。
+ *  输出与顺序执行完全相同。
+ */
+class ConversionScheduler
+{
+public:
+    /// threadCount 为0时按硬件线程数
+    explicit ConversionScheduler(unsigned threadCount = 0);
+
+    /// 分别输出：每个 bin 生成同名 .csv（或 .arrow）
+    ConversionReport convertSeparate(const std::vector<std::string> &binPaths,
+                                     const ConversionOptions &options = ConversionOptions());
+
+    /// 合并输出：各文件并行解析后按时间 k 路归并写入一个文件；超出 memoryBudget 时
+    /// 经临时文件外部归并。任一文件解析失败时不写出，报告全部失败文件。
+    ConversionReport convertMerged(const std::vector<std::string> &binPaths,
+                                   const std::string &csvFilename,
+                                   const ConversionOptions &options = ConversionOptions());
+
+private:
+    ParseOptions parseOptions(const ConversionOptions &options);
+    StreamOptions streamOptions(const ConversionOptions &options);
+    ConversionReport convertMergedStreaming(const std::vector<std::string> &binPaths,
+                                            const std::string &csvFilename,
+                                            const ConversionOptions &options);
+    ConversionReport convertMergedSpilling(const std::vector<std::string> &binPaths,
+                                           const std::string &csvFilename,
+                                           const ConversionOptions &options);
+
+    ThreadPool m_pool;
+    /// 各文件解析用的记录表，转换完归还；多次转换（GUI、监视模式）之间复用已分配的内存
+    RecyclePool<RecordTable> m_tables;
+};
+
+#endif // CONVERTER_H
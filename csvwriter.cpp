@@ -0,0 +1,212 @@
+#include "csvwriter.h"
+#include "recordtable.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// 每行预留的最大长度（日期+时间+13个最长的 "%g" 值）
+static const size_t kMaxRowBytes = 32 + kChannelCount * 32;
+
+// CSV 表头(UTF-8)：日期,时间,各通道名
+static std::string csvHeader(uint32_t columnMask)
+{
+    std::string header = "日期,时间";
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if ((columnMask >> c) & 1) {
+            header += ',';
+            header += kChannelNames[c];
+        }
+    }
+    header += '\n';
+    return header;
+}
+
+char *formatFloat(char *p, float value)
+{
+    // 快速路径：value 恰为某个两位小数 n/100 最接近的 float 且 |value| < 10000，
+    // 此时 "%g" 的6位有效数字足以精确还原 n/100，输出即 n/100 去掉末尾的0
+    if (value > -10000.0f && value < 10000.0f) {
+        double n = std::nearbyint(value * 100.0);
+        if (static_cast<float>(n / 100.0) == value) {
+            if (std::signbit(value)) {
+                *p++ = '-';
+            }
+            unsigned long v = (unsigned long)std::fabs(n);
+            unsigned long ip = v / 100;
+            unsigned long fp = v % 100;
+            p = std::to_chars(p, p + 8, ip).ptr;
+            if (fp != 0) {
+                *p++ = '.';
+                *p++ = (char)('0' + fp / 10);
+                if (fp % 10 != 0) {
+                    *p++ = (char)('0' + fp % 10);
+                }
+            }
+            return p;
+        }
+    }
+    return std::to_chars(p, p + 32, static_cast<double>(value), std::chars_format::general, 6).ptr;
+}
+
+#ifdef _WIN32
+// UTF-8 -> 本地ACP(ANSI)
+static std::string utf8ToAnsi(const char *data, size_t size)
+{
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, data, (int)size, NULL, 0);
+    if (wlen <= 0) return std::string();
+    std::wstring wbuf(wlen, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, data, (int)size, &wbuf[0], wlen);
+    int alen = WideCharToMultiByte(CP_ACP, 0, wbuf.c_str(), wlen, NULL, 0, NULL, NULL);
+    if (alen <= 0) return std::string();
+    std::string abuf(alen, '\0');
+    WideCharToMultiByte(CP_ACP, 0, wbuf.c_str(), wlen, &abuf[0], alen, NULL, NULL);
+    return abuf;
+}
+
+// 是否全为ASCII字节（ASCII在所有ANSI代码页下与UTF-8相同，无需转换）
+static bool isAscii(const char *data, size_t size)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t v;
+        std::memcpy(&v, p + i, 8);
+        if (v & 0x8080808080808080ULL) return false;
+    }
+    for (; i < size; ++i) {
+        if (p[i] & 0x80) return false;
+    }
+    return true;
+}
+#endif
+
+CsvWriter::CsvWriter(const std::string &csvFilename, CsvEncoding encoding, bool append,
+                     uint32_t columnMask)
+    : m_filename(csvFilename)
+    , m_columnMask(columnMask)
+{
+// 写CSV (Windows下ANSI，其他平台默认UTF-8)
+    if (!m_file.open(csvFilename, append)) {
+        throw std::runtime_error("无法创建CSV文件：" + csvFilename);
+    }
+
+#ifdef _WIN32
+    m_toAnsi = (encoding == CsvEncoding::Native);
+#endif
+    if (encoding == CsvEncoding::Utf8Bom && !append) {
+        static const char kBom[] = "\xEF\xBB\xBF";
+        std::memcpy(reserve(3), kBom, 3);
+        m_used += 3;
+    }
+}
+
+char *CsvWriter::reserve(size_t bytes)
+{
+    if (kOutputBlockBytes - m_used < bytes) {
+        flush();
+    }
+    return m_file.buffer() + m_used;
+}
+
+char *CsvWriter::writeValues(char *p, const float *values, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        p = formatFloat(p, values[i]);
+        if (i + 1 < count) *p++ = ',';
+    }
+    *p++ = '\n';
+    return p;
+}
+
+void CsvWriter::writeHeader()
+{
+    std::string header = csvHeader(m_columnMask);
+#ifdef _WIN32
+    if (m_toAnsi) {
+        // 表头已转换为ANSI字节，单独成块写出，不再经过 flush 的转换
+        std::string ansiHeader = utf8ToAnsi(header.data(), header.size());
+        flush();
+        std::memcpy(m_file.buffer(), ansiHeader.data(), ansiHeader.size());
+        submit(ansiHeader.size());
+        return;
+    }
+#endif
+    std::memcpy(reserve(header.size()), header.data(), header.size());
+    m_used += header.size();
+}
+
+void CsvWriter::writeRow(uint64_t ts, const float *values, size_t count)
+{
+    char *begin = reserve(kMaxRowBytes);
+    char *p = begin;
+    p += formatDate(ts, p);
+    *p++ = ',';
+    p += formatTime(ts, p);
+    *p++ = ',';
+    p = writeValues(p, values, count);
+    m_used += (size_t)(p - begin);
+    ++m_rows;
+}
+
+void CsvWriter::writeRow(const std::string &dateStr, const std::string &timeStr,
+                         const float *values, size_t count)
+{
+    char *begin = reserve(dateStr.size() + timeStr.size() + 2 + count * 32 + 1);
+    char *p = begin;
+    std::memcpy(p, dateStr.data(), dateStr.size());
+    p += dateStr.size();
+    *p++ = ',';
+    std::memcpy(p, timeStr.data(), timeStr.size());
+    p += timeStr.size();
+    *p++ = ',';
+    p = writeValues(p, values, count);
+    m_used += (size_t)(p - begin);
+    ++m_rows;
+}
+
+void CsvWriter::flush()
+{
+    if (m_used == 0) {
+        return;
+    }
+    size_t size = m_used;
+    m_used = 0;
+
+#ifdef _WIN32
+    // 缓冲区总在行边界刷新；数据行为纯ASCII，只有含非ASCII字节的块才需转换。
+    // ANSI 编码不比 UTF-8 长，转换结果原地放回
+    if (m_toAnsi && !isAscii(m_file.buffer(), size)) {
+        std::string abuf = utf8ToAnsi(m_file.buffer(), size);
+        size = std::min(abuf.size(), kOutputBlockBytes);
+        std::memcpy(m_file.buffer(), abuf.data(), size);
+    }
+#endif
+    submit(size);
+}
+
+void CsvWriter::submit(size_t size)
+{
+    if (!m_file.submit(size)) {
+        throw std::runtime_error("写CSV失败：" + m_filename);
+    }
+}
+
+void CsvWriter::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    flush();
+    perfCount(PerfCounter::RowsWritten, m_rows);
+    if (!m_file.close()) {
+        throw std::runtime_error("写CSV失败：" + m_filename);
+    }
+}
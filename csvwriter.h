@@ -0,0 +1,73 @@
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "outputfile.h"
+#include "recordsink.h"
+#include "recordtable.h"
+
+/**
+ * @brief formatFloat
+ *  按 std::ostream 默认格式（即 "%g"，6位有效数字）输出 float，
+ *  已保留两位小数的值走定点快速路径，其余交给 std::to_chars。
+ *  p 处至少需要 32 字节空间，返回写入末尾。
+ */
+char *formatFloat(char *p, float value);
+
+/// CSV 文件编码
+enum class CsvEncoding {
+    Native,   ///< Windows 下为本地ANSI代码页，其他平台为UTF-8
+    Utf8,     ///< UTF-8，无BOM
+    Utf8Bom,  ///< UTF-8 带BOM，Excel 可直接识别
+};
+
+/**
+ * @brief CsvWriter
+ *  CSV 文件写出器：行直接格式化到输出文件的缓冲区（见 OutputFile），写满后整块交给
+ *  后台线程写出，同时格式化下一块。新建的文件在 close() 成功后才出现，
+ *  未 close() 即销毁时丢弃输出。
+ *  编码转换只作用于表头及含非ASCII字节的数据块，纯ASCII数据行原样写出。
+ *  打开或写入失败抛出 std::runtime_error。
+ */
+class CsvWriter : public RecordSink
+{
+public:
+    /// append 为 true 时追加到已有文件末尾（不写BOM，表头由调用方决定）；
+    /// columnMask 为输出的通道列，表头只含这些列
+    explicit CsvWriter(const std::string &csvFilename,
+                       CsvEncoding encoding = CsvEncoding::Native, bool append = false,
+                       uint32_t columnMask = kAllColumns);
+    CsvWriter(const CsvWriter &) = delete;
+    CsvWriter &operator=(const CsvWriter &) = delete;
+
+    /// 写表头（日期,时间,各输出列的通道名）
+    void writeHeader() override;
+    /// 写一行：打包时间戳 + count 个值
+    void writeRow(uint64_t ts, const float *values, size_t count) override;
+    /// 写一行：已格式化的日期、时间文本 + count 个值
+    void writeRow(const std::string &dateStr, const std::string &timeStr,
+                  const float *values, size_t count);
+
+    /// 刷新缓冲并关闭文件，失败时抛出异常
+    void close() override;
+
+private:
+    char *reserve(size_t bytes);
+    char *writeValues(char *p, const float *values, size_t count);
+    void flush();
+    void submit(size_t size);
+
+    std::string m_filename;
+    uint32_t m_columnMask;
+    bool m_toAnsi = false;
+    OutputFile m_file;
+    size_t m_used = 0;          ///< m_file 当前缓冲中已写入的字节
+    uint64_t m_rows = 0;    ///< 已写出的数据行，关闭时计入统计
+};
+
+#endif // CSVWRITER_H
@@ -0,0 +1,214 @@
+#include "decodekernel.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define BINT_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && \
+      (!defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define BINT_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang 需按函数开启指令集，MSVC 可直接使用内建函数
+#if defined(BINT_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BINT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BINT_TARGET(isa)
+#endif
+
+typedef void (*DecodeFloatsFn)(const unsigned char *, float *, size_t);
+
+// 标量实现：按大端组成 uint32，字节交换一次得到 float 位模式，保留两位小数
+static void decodeFloatsScalar(const unsigned char *src, float *dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, src += 4) {
+        uint32_t word = ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) |
+                        ((uint32_t)src[2] << 8) | (uint32_t)src[3];
+        uint32_t bits = swapBigEndianToHost(word);
+        float f;
+        std::memcpy(&f, &bits, sizeof(float));
+        dst[i] = static_cast<float>(std::round(f * 100.0) / 100.0);
+    }
+}
+
+// 以下向量实现均在小端主机上：大端字交换一次后的位模式即原始4字节按小端读取，
+// 因此直接整块加载为 float，免去逐字的移位拼接与交换。
+// 舍入与标量完全一致：提升为 double、乘100、round(远离0取整)、除100、转回 float。
+
+#if defined(BINT_X86)
+
+BINT_TARGET("sse4.1")
+static inline __m128d roundHundredthsSse41(__m128d x)
+{
+    const __m128d k100 = _mm_set1_pd(100.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    x = _mm_mul_pd(x, k100);
+    // std::round: 截断后若小数部分绝对值 >= 0.5 则远离0进1；用 blend 保留 -0 的符号
+    __m128d t = _mm_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m128d frac = _mm_andnot_pd(signBit, _mm_sub_pd(x, t));
+    __m128d carry = _mm_cmpge_pd(frac, _mm_set1_pd(0.5));
+    __m128d one = _mm_or_pd(_mm_set1_pd(1.0), _mm_and_pd(x, signBit));
+    t = _mm_blendv_pd(t, _mm_add_pd(t, one), carry);
+    return _mm_div_pd(t, k100);
+}
+
+BINT_TARGET("sse4.1")
+static inline __m128 roundFloatsSse41(__m128 raw)
+{
+    __m128d lo = roundHundredthsSse41(_mm_cvtps_pd(raw));
+    __m128d hi = roundHundredthsSse41(_mm_cvtps_pd(_mm_movehl_ps(raw, raw)));
+    return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+BINT_TARGET("sse4.1")
+static void decodeFloatsSse41(const unsigned char *src, float *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 raw = _mm_loadu_ps(reinterpret_cast<const float *>(src + i * 4));
+        _mm_storeu_ps(dst + i, roundFloatsSse41(raw));
+    }
+    decodeFloatsScalar(src + i * 4, dst + i, count - i);
+}
+
+BINT_TARGET("avx2")
+static inline __m256d roundHundredthsAvx2(__m256d x)
+{
+    const __m256d k100 = _mm256_set1_pd(100.0);
+    const __m256d signBit = _mm256_set1_pd(-0.0);
+    x = _mm256_mul_pd(x, k100);
+    __m256d t = _mm256_round_pd(x, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    __m256d frac = _mm256_andnot_pd(signBit, _mm256_sub_pd(x, t));
+    __m256d carry = _mm256_cmp_pd(frac, _mm256_set1_pd(0.5), _CMP_GE_OQ);
+    __m256d one = _mm256_or_pd(_mm256_set1_pd(1.0), _mm256_and_pd(x, signBit));
+    t = _mm256_blendv_pd(t, _mm256_add_pd(t, one), carry);
+    return _mm256_div_pd(t, k100);
+}
+
+// 每次8个 float：两组各4个提升为 double 舍入
+BINT_TARGET("avx2")
+static void decodeFloatsAvx2(const unsigned char *src, float *dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 raw = _mm256_loadu_ps(reinterpret_cast<const float *>(src + i * 4));
+        __m256d lo = roundHundredthsAvx2(_mm256_cvtps_pd(_mm256_castps256_ps128(raw)));
+        __m256d hi = roundHundredthsAvx2(_mm256_cvtps_pd(_mm256_extractf128_ps(raw, 1)));
+        __m256 out = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)),
+                                          _mm256_cvtpd_ps(hi), 1);
+        _mm256_storeu_ps(dst + i, out);
+    }
+    for (; i + 4 <= count; i += 4) {
+        __m128 raw = _mm_loadu_ps(reinterpret_cast<const float *>(src + i * 4));
+        __m256d d = roundHundredthsAvx2(_mm256_cvtps_pd(raw));
+        _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(d));
+    }
+    decodeFloatsScalar(src + i * 4, dst + i, count - i);
+}
+
+static bool cpuHasSse41()
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 19)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.1");
+#endif
+}
+
+static bool cpuHasAvx2()
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false; // 操作系统未开启 YMM 状态保存
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(BINT_NEON)
+
+static void decodeFloatsNeon(const unsigned char *src, float *dst, size_t count)
+{
+    const float64x2_t k100 = vdupq_n_f64(100.0);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t raw = vld1q_f32(reinterpret_cast<const float *>(src + i * 4));
+        // vrndaq 即远离0取整，与 std::round 相同
+        float64x2_t lo = vdivq_f64(vrndaq_f64(vmulq_f64(vcvt_f64_f32(vget_low_f32(raw)), k100)), k100);
+        float64x2_t hi = vdivq_f64(vrndaq_f64(vmulq_f64(vcvt_high_f64_f32(raw), k100)), k100);
+        vst1q_f32(dst + i, vcvt_high_f32_f64(vcvt_f32_f64(lo), hi));
+    }
+    decodeFloatsScalar(src + i * 4, dst + i, count - i);
+}
+
+#endif
+
+struct KernelChoice {
+    DecodeIsa isa;
+    DecodeFloatsFn fn;
+    const char *name;
+};
+
+static KernelChoice chooseKernel(DecodeIsa wanted)
+{
+#if defined(BINT_X86)
+    if ((wanted == DecodeIsa::Auto || wanted == DecodeIsa::Avx2) && cpuHasAvx2()) {
+        return KernelChoice{ DecodeIsa::Avx2, decodeFloatsAvx2, "avx2" };
+    }
+    if ((wanted == DecodeIsa::Auto || wanted == DecodeIsa::Avx2 || wanted == DecodeIsa::Sse41) &&
+        cpuHasSse41()) {
+        return KernelChoice{ DecodeIsa::Sse41, decodeFloatsSse41, "sse4.1" };
+    }
+#elif defined(BINT_NEON)
+    if (wanted != DecodeIsa::Scalar) {
+        return KernelChoice{ DecodeIsa::Neon, decodeFloatsNeon, "neon" };
+    }
+#endif
+    (void)wanted;
+    return KernelChoice{ DecodeIsa::Scalar, decodeFloatsScalar, "scalar" };
+}
+
+static std::atomic<DecodeFloatsFn> g_decodeFloats{ nullptr };
+static std::atomic<const char *> g_decodeIsaName{ "scalar" };
+
+void decodeFloats(const unsigned char *src, float *dst, size_t count)
+{
+    DecodeFloatsFn fn = g_decodeFloats.load(std::memory_order_relaxed);
+    if (!fn) {
+        setDecodeIsa(DecodeIsa::Auto);
+        fn = g_decodeFloats.load(std::memory_order_relaxed);
+    }
+    fn(src, dst, count);
+}
+
+DecodeIsa setDecodeIsa(DecodeIsa isa)
+{
+    KernelChoice choice = chooseKernel(isa);
+    g_decodeIsaName.store(choice.name);
+    g_decodeFloats.store(choice.fn);
+    return choice.isa;
+}
+
+const char *decodeIsaName()
+{
+    if (!g_decodeFloats.load()) {
+        setDecodeIsa(DecodeIsa::Auto);
+    }
+    return g_decodeIsaName.load();
+}
@@ -0,0 +1,43 @@
+#ifndef DECODEKERNEL_H
+#define DECODEKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 大端转小端
+static inline uint32_t swapBigEndianToHost(uint32_t v)
+{
+#if defined(_MSC_VER)
+    return _byteswap_ulong(v);  // MSVC
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(v); // GCC/Clang
+#else
+    return ((v & 0xFF000000) >> 24) |
+           ((v & 0x00FF0000) >>  8) |
+           ((v & 0x0000FF00) <<  8) |
+           ((v & 0x000000FF) << 24);
+#endif
+}
+
+/// float 解码内核的指令集
+enum class DecodeIsa {
+    Auto,     ///< 运行时按CPU选择
+    Scalar,
+    Sse41,
+    Avx2,
+    Neon,
+};
+
+/**
+ * @brief decodeFloats
+ *  将 src 处连续 count 个大端 uint32 按 float 解码并保留两位小数，
+ *  结果与逐个 std::round(f * 100.0) / 100.0 完全一致。
+ */
+void decodeFloats(const unsigned char *src, float *dst, size_t count);
+
+/// 指定解码内核（Auto 按CPU选择；不支持的指令集自动回退），返回实际使用的指令集
+DecodeIsa setDecodeIsa(DecodeIsa isa);
+/// 当前使用的指令集名称
+const char *decodeIsaName();
+
+#endif // DECODEKERNEL_H
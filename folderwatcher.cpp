@@ -0,0 +1,227 @@
+#include "folderwatcher.h"
+
+#include <algorithm>
+#include <cctype>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+// 没有待定文件时最长等待多久重新扫描一次（兼顾网络共享与取消响应）
+static const std::chrono::milliseconds kIdleRescan(1000);
+
+static bool hasBinExtension(const fs::path &path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    return ext == ".bin";
+}
+
+FolderWatcher::FolderWatcher(const std::vector<std::string> &dirs, bool recursive,
+                             std::chrono::milliseconds settle)
+    : m_dirs(dirs)
+    , m_recursive(recursive)
+    , m_settle(settle)
+{
+#if defined(__linux__)
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    for (const std::string &dir : m_dirs) {
+        watchDirectory(dir);
+    }
+}
+
+FolderWatcher::~FolderWatcher()
+{
+#ifdef _WIN32
+    for (void *handle : m_handles) {
+        FindCloseChangeNotification((HANDLE)handle);
+    }
+#else
+    if (m_inotify >= 0) {
+        ::close(m_inotify);
+    }
+#endif
+}
+
+void FolderWatcher::watchDirectory(const std::string &dir)
+{
+    if (!m_watched.insert(dir).second) {
+        return;
+    }
+#ifdef _WIN32
+    // 子目录由同一个通知覆盖
+    HANDLE handle = FindFirstChangeNotificationA(
+            dir.c_str(), m_recursive ? TRUE : FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+            FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (handle != INVALID_HANDLE_VALUE && m_handles.size() < MAXIMUM_WAIT_OBJECTS) {
+        m_handles.push_back(handle);
+    } else if (handle != INVALID_HANDLE_VALUE) {
+        FindCloseChangeNotification(handle);
+    }
+#elif defined(__linux__)
+    // 添加失败（如超出 max_user_watches）时该目录只靠定期扫描
+    if (m_inotify >= 0) {
+        inotify_add_watch(m_inotify, dir.c_str(),
+                          IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_TO |
+                          IN_MOVED_FROM | IN_DELETE);
+    }
+#endif
+}
+
+void FolderWatcher::scan()
+{
+    Clock::time_point now = Clock::now();
+    std::set<std::string> seen;
+    auto visit = [&](const fs::directory_entry &entry) {
+        std::error_code ec;
+        if (entry.is_directory(ec)) {
+#ifndef _WIN32
+            watchDirectory(entry.path().string());
+#endif
+            return;
+        }
+        if (!entry.is_regular_file(ec) || !hasBinExtension(entry.path())) {
+            return;
+        }
+        uint64_t size = entry.file_size(ec);
+        if (ec) {
+            return;
+        }
+        fs::file_time_type mtime = entry.last_write_time(ec);
+        if (ec) {
+            return;
+        }
+        std::string path = entry.path().string();
+        seen.insert(path);
+        auto it = m_files.find(path);
+        if (it == m_files.end()) {
+            FileState state;
+            state.size = size;
+            state.mtime = mtime;
+            state.changed = now;
+            m_files.emplace(path, state);
+        } else if (it->second.size != size || it->second.mtime != mtime) {
+            it->second.size = size;
+            it->second.mtime = mtime;
+            it->second.changed = now;
+            it->second.reported = false;
+        }
+    };
+
+    const fs::directory_options opts = fs::directory_options::skip_permission_denied;
+    for (const std::string &dir : m_dirs) {
+        std::error_code ec;
+        if (m_recursive) {
+            for (fs::recursive_directory_iterator it(dir, opts, ec), end; !ec && it != end;
+                 it.increment(ec)) {
+                visit(*it);
+            }
+        } else {
+            for (fs::directory_iterator it(dir, opts, ec), end; !ec && it != end;
+                 it.increment(ec)) {
+                visit(*it);
+            }
+        }
+    }
+
+    // 已删除或改名的文件不再跟踪
+    for (auto it = m_files.begin(); it != m_files.end(); ) {
+        if (seen.count(it->first)) {
+            ++it;
+        } else {
+            it = m_files.erase(it);
+        }
+    }
+}
+
+void FolderWatcher::waitForChange(std::chrono::milliseconds timeout)
+{
+#ifdef _WIN32
+    if (m_handles.empty()) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    DWORD result = WaitForMultipleObjects((DWORD)m_handles.size(), (const HANDLE *)m_handles.data(),
+                                          FALSE, (DWORD)timeout.count());
+    if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + m_handles.size()) {
+        FindNextChangeNotification((HANDLE)m_handles[result - WAIT_OBJECT_0]);
+    }
+#elif defined(__linux__)
+    if (m_inotify < 0) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    // 信号会打断 poll，取消可立即生效
+    struct pollfd pfd = { m_inotify, POLLIN, 0 };
+    if (poll(&pfd, 1, (int)timeout.count()) > 0) {
+        // 事件内容不重要，全部读掉后重新扫描
+        alignas(struct inotify_event) char buffer[4096];
+        while (read(m_inotify, buffer, sizeof(buffer)) > 0) {
+        }
+    }
+#else
+    std::this_thread::sleep_for(timeout);
+#endif
+}
+
+std::vector<std::string> FolderWatcher::waitReady(const std::atomic<bool> *cancel)
+{
+    std::vector<std::string> ready;
+    while (!(cancel && cancel->load())) {
+        scan();
+        Clock::time_point now = Clock::now();
+        std::chrono::milliseconds timeout = kIdleRescan;
+        bool pending = false;
+        for (auto &item : m_files) {
+            FileState &state = item.second;
+            // 空文件多半刚创建、尚未写入
+            if (state.reported || state.size == 0) {
+                continue;
+            }
+            auto quiet = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.changed);
+            if (quiet >= m_settle) {
+                state.reported = true;
+                state.known = true;
+                ready.push_back(item.first);
+            } else {
+                timeout = std::min(timeout, m_settle - quiet);
+                pending = true;
+            }
+        }
+        if (!ready.empty()) {
+            return ready;   // m_files 按路径有序
+        }
+        // 有文件正在写入时不必每次写入都唤醒，到期再看
+        timeout = std::max(timeout, std::chrono::milliseconds(1));
+        if (pending) {
+            std::this_thread::sleep_for(timeout);
+        } else {
+            waitForChange(timeout);
+        }
+    }
+    return ready;
+}
+
+std::vector<std::string> FolderWatcher::knownFiles() const
+{
+    std::vector<std::string> files;
+    for (const auto &item : m_files) {
+        if (item.second.known) {
+            files.push_back(item.first);
+        }
+    }
+    return files;
+}
@@ -0,0 +1,66 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief FolderWatcher
+ *  监视若干目录中的 .bin 文件，新文件（或再次变化的文件）大小与修改时间
+ *  连续 settle 时长不变后视为写完，由 waitReady 报告一次。
+ *  Linux 用 inotify、Windows 用目录变更通知唤醒，目录有变化时立即重新扫描；
+ *  网络共享上另一台机器写入的文件不一定产生通知，因此空闲时仍定期扫描。
+ *  启动时已有的文件同样按新文件处理。
+ */
+class FolderWatcher
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    FolderWatcher(const std::vector<std::string> &dirs, bool recursive,
+                  std::chrono::milliseconds settle = std::chrono::milliseconds(300));
+    ~FolderWatcher();
+
+    FolderWatcher(const FolderWatcher &) = delete;
+    FolderWatcher &operator=(const FolderWatcher &) = delete;
+
+    /// 阻塞到有文件写完，返回这些文件（按路径排序）；cancel 置为 true 时返回空列表
+    std::vector<std::string> waitReady(const std::atomic<bool> *cancel);
+
+    /// 至今报告过且仍存在的全部文件（按路径排序），供合并输出；
+    /// 报告后又在追加写入的文件也包括在内
+    std::vector<std::string> knownFiles() const;
+
+private:
+    struct FileState {
+        uint64_t size = 0;
+        std::filesystem::file_time_type mtime;
+        Clock::time_point changed;      ///< 最近一次看到大小或修改时间变化
+        bool reported = false;          ///< 当前大小与修改时间已报告过
+        bool known = false;             ///< 曾经报告过（之后又在写入也算）
+    };
+
+    void scan();
+    void watchDirectory(const std::string &dir);
+    /// 等待目录变化或超时
+    void waitForChange(std::chrono::milliseconds timeout);
+
+    std::vector<std::string> m_dirs;
+    bool m_recursive;
+    std::chrono::milliseconds m_settle;
+    std::map<std::string, FileState> m_files;
+    std::set<std::string> m_watched;
+#ifdef _WIN32
+    std::vector<void *> m_handles;      // FindFirstChangeNotification 的 HANDLE
+#else
+    int m_inotify = -1;
+#endif
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,274 @@
+#include "incremental.h"
+#include "inputsource.h"
+#include "parsebin.h"
+#include "perfstats.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char kCheckpointMagic[] = "bint-checkpoint 1";
+static const size_t kAppendBatchBlocks = 16384;
+
+static uint64_t hashBlock(const unsigned char *p, size_t size)
+{
+    uint64_t h = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+static inline bool isCancelled(const AppendOptions &options)
+{
+    return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+std::string checkpointPathFor(const std::string &csvFilename)
+{
+    return csvFilename + ".ckpt";
+}
+
+bool readCheckpoint(const std::string &path, Checkpoint &checkpoint)
+{
+    FILE *fp = std::fopen(path.c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char line[128];
+    bool ok = std::fgets(line, sizeof(line), fp) &&
+              std::strncmp(line, kCheckpointMagic, sizeof(kCheckpointMagic) - 1) == 0;
+    unsigned seen = 0;
+    Checkpoint c;
+    while (ok && std::fgets(line, sizeof(line), fp)) {
+        uint64_t u;
+        int64_t i;
+        if (std::sscanf(line, "input_size=%" SCNu64, &u) == 1) {
+            c.inputSize = u;
+            seen |= 1;
+        } else if (std::sscanf(line, "input_mtime=%" SCNd64, &i) == 1) {
+            c.inputMtime = i;
+            seen |= 2;
+        } else if (std::sscanf(line, "offset=%" SCNu64, &u) == 1) {
+            c.offset = u;
+            seen |= 4;
+        } else if (std::sscanf(line, "block_hash=%" SCNx64, &u) == 1) {
+            c.blockHash = u;
+            seen |= 8;
+        } else if (std::sscanf(line, "has_rows=%" SCNu64, &u) == 1) {
+            c.hasRows = u != 0;
+            seen |= 16;
+        } else if (std::sscanf(line, "last_timestamp=%" SCNx64, &u) == 1) {
+            c.lastTimestamp = u;
+            seen |= 32;
+        } else if (std::sscanf(line, "csv_size=%" SCNu64, &u) == 1) {
+            c.csvSize = u;
+            seen |= 64;
+        } else if (std::strncmp(line, "layout=", 7) == 0) {
+            // 早期断点没有这一行，即默认布局
+            c.layout = line + 7;
+            c.layout.erase(c.layout.find_last_not_of("\r\n") + 1);
+        }
+    }
+    std::fclose(fp);
+    if (!ok || seen != 127) {
+        return false;
+    }
+    checkpoint = c;
+    return true;
+}
+
+void writeCheckpoint(const std::string &path, const Checkpoint &c)
+{
+    std::string tmp = path + ".tmp";
+    FILE *fp = std::fopen(tmp.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("无法写断点文件：" + tmp);
+    }
+    int n = std::fprintf(fp,
+                         "%s\n"
+                         "input_size=%" PRIu64 "\n"
+                         "input_mtime=%" PRId64 "\n"
+                         "offset=%" PRIu64 "\n"
+                         "block_hash=%016" PRIx64 "\n"
+                         "has_rows=%d\n"
+                         "last_timestamp=%" PRIx64 "\n"
+                         "csv_size=%" PRIu64 "\n"
+                         "layout=%s\n",
+                         kCheckpointMagic, c.inputSize, c.inputMtime, c.offset, c.blockHash,
+                         c.hasRows ? 1 : 0, c.lastTimestamp, c.csvSize, c.layout.c_str());
+    if (std::fclose(fp) != 0 || n < 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("无法写断点文件：" + tmp);
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("无法写断点文件：" + path);
+    }
+}
+
+// 断点是否仍对应当前的输入与CSV；CSV 比断点记录的长（追加后未及写断点）时截回
+static bool canResume(const Checkpoint &c, const RecordLayout &layout, uint64_t inputSize,
+                      const std::string &csvFilename)
+{
+    uint64_t dataOffset = layout.dataOffset();
+    if (c.layout != layout.toString() || c.offset < dataOffset ||
+        (c.offset - dataOffset) % layout.subsequentBlockSize != 0 ||
+        c.offset > inputSize || inputSize < c.inputSize) {
+        return false;
+    }
+    std::error_code ec;
+    uint64_t csvSize = fs::file_size(csvFilename, ec);
+    if (ec || csvSize < c.csvSize) {
+        return false;
+    }
+    if (csvSize > c.csvSize) {
+        fs::resize_file(csvFilename, c.csvSize, ec);
+        if (ec) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 从断点位置解析新增的块并写出。fresh 为 true 时重写整个CSV；
+// 否则追加，新数据早于 CSV 末行时返回 false（需重建）
+static bool convertFrom(const std::string &binFilename, const std::string &csvFilename,
+                        const RecordLayout &layout, const AppendOptions &options, bool fresh,
+                        Checkpoint &c, AppendStats &stats)
+{
+    BinBlockReader reader(binFilename, layout);
+    const size_t blockSize = reader.blockSize();
+    size_t done = (size_t)((c.offset - reader.dataOffset()) / blockSize);
+    if (!fresh) {
+        // 单独的首块上次已解析；确认断点前最后一块未被改写
+        reader.skipBlocks(done > 0 ? done - 1 : 0);
+        if (done > 0) {
+            size_t count;
+            const unsigned char *p = reader.nextBlocks(1, count);
+            if (count != 1 || hashBlock(p, blockSize) != c.blockHash) {
+                return false;
+            }
+        }
+    }
+    if (options.progress) {
+        options.progress(c.offset, 0);
+    }
+
+    RecordTable table;
+    uint64_t blocks = 0;
+    uint64_t lastHash = c.blockHash;
+    while (true) {
+        if (isCancelled(options)) {
+            throw ParseCancelled();
+        }
+        size_t before = table.size();
+        size_t n = reader.decodeNext(table, kAppendBatchBlocks);
+        if (n == 0) {
+            break;
+        }
+        blocks += n;
+        lastHash = hashBlock(reader.lastBlock(), blockSize);
+        if (options.progress) {
+            options.progress(n * blockSize, table.size() - before);
+        }
+    }
+
+    std::vector<uint32_t> order;
+    bool sorted = !sortRowOrder(table.timestamps.data(), table.size(), order);
+    const std::vector<uint64_t> &ts = table.timestamps;
+    if (!fresh && c.hasRows && !ts.empty() && ts[sorted ? 0 : order[0]] < c.lastTimestamp) {
+        return false;
+    }
+    if (isCancelled(options)) {
+        throw ParseCancelled();
+    }
+
+    PerfTimer timer(PerfStage::Format);
+    CsvWriter writer(csvFilename, options.encoding, !fresh);
+    if (fresh) {
+        writer.writeHeader();
+    }
+    // 新行按时间稳定排序；与 CSV 末行同一时间戳的行已有先出现的一条，跳过
+    for (size_t k = 0; k < table.size(); ++k) {
+        size_t i = sorted ? k : order[k];
+        if (c.hasRows && ts[i] == c.lastTimestamp) {
+            continue;
+        }
+        float values[kChannelCount];
+        for (size_t col = 0; col < kChannelCount; ++col) {
+            values[col] = table.columns[col][i];
+        }
+        writer.writeRow(ts[i], values, kChannelCount);
+        ++stats.rowsAppended;
+        c.hasRows = true;
+        c.lastTimestamp = ts[i];
+    }
+    writer.close();
+
+    stats.blocksDecoded = blocks;
+    c.offset += blocks * blockSize;
+    c.blockHash = lastHash;
+    std::error_code ec;
+    c.csvSize = fs::file_size(csvFilename, ec);
+    if (ec) {
+        throw std::runtime_error("写CSV失败：" + csvFilename);
+    }
+    return true;
+}
+
+AppendStats appendBinToCsv(const std::string &binFilename, const std::string &csvFilename,
+                           const AppendOptions &options)
+{
+    // 断点记录的是解码位置，须与输入文件大小可比：压缩输入的文件大小是压缩后的，
+    // 标准输入没有大小与修改时间，都无法判断是否有新增的块
+    if (inputKindForPath(binFilename) != InputKind::File) {
+        throw std::runtime_error("增量转换只支持未压缩的 .bin 文件：" + binFilename);
+    }
+    std::error_code ec;
+    uint64_t inputSize = fs::file_size(binFilename, ec);
+    if (ec) {
+        throw std::runtime_error("无法打开文件：" + binFilename);
+    }
+    int64_t inputMtime = (int64_t)fs::last_write_time(binFilename, ec).time_since_epoch().count();
+
+    const RecordLayout layout = options.layout ? *options.layout : RecordLayout();
+    std::string checkpointPath = checkpointPathFor(csvFilename);
+    AppendStats stats;
+    Checkpoint c;
+    bool resume = readCheckpoint(checkpointPath, c) &&
+                  canResume(c, layout, inputSize, csvFilename);
+    if (resume && c.inputSize == inputSize && c.inputMtime == inputMtime) {
+        stats.upToDate = true;
+        return stats;
+    }
+
+    Checkpoint next = c;
+    if (!resume || !convertFrom(binFilename, csvFilename, layout, options, false, next, stats)) {
+        // 从头重建；先删除旧断点，重建中途失败或取消时保留原 CSV（新文件 close 后才替换），
+        // 下次因没有断点仍会重建
+        std::remove(checkpointPath.c_str());
+        stats = AppendStats();
+        stats.rebuilt = true;
+        next = Checkpoint();
+        next.offset = layout.dataOffset();
+        next.layout = layout.toString();
+        convertFrom(binFilename, csvFilename, layout, options, true, next, stats);
+        if (inputSize < next.offset) {
+            // 还没有完整的首块，断点无效，下次重建
+            next.offset = 0;
+        }
+    }
+    next.inputSize = inputSize;
+    next.inputMtime = inputMtime;
+    writeCheckpoint(checkpointPath, next);
+    return stats;
+}
@@ -0,0 +1,69 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "csvwriter.h"
+#include "recordlayout.h"
+
+/**
+ * @brief Checkpoint
+ *  增量转换的断点，与 CSV 放在一起（见 checkpointPathFor）。
+ *  记录已转换到的输入位置和 CSV 的状态，用来判断下次能否只解析新增的块。
+ */
+struct Checkpoint {
+    uint64_t inputSize = 0;         ///< 上次转换时输入文件大小
+    int64_t inputMtime = 0;         ///< 上次转换时输入文件修改时间（仅比较是否相同）
+    uint64_t offset = 0;            ///< 已解析到的字节偏移（总在块边界）
+    uint64_t blockHash = 0;         ///< offset 之前最后一个块的 FNV-1a 哈希，用于识别被改写的输入
+    bool hasRows = false;           ///< CSV 中是否已有数据行
+    uint64_t lastTimestamp = 0;     ///< CSV 最后一行的打包时间戳
+    uint64_t csvSize = 0;           ///< 写完后 CSV 的大小
+    std::string layout = RecordLayout().toString(); ///< 转换时的记录布局（RecordLayout::toString）
+};
+
+/// CSV 对应的断点文件路径
+std::string checkpointPathFor(const std::string &csvFilename);
+
+/// 读取断点文件，不存在或格式不对时返回 false
+bool readCheckpoint(const std::string &path, Checkpoint &checkpoint);
+
+/// 写断点文件（先写临时文件再改名），失败时抛出 std::runtime_error
+void writeCheckpoint(const std::string &path, const Checkpoint &checkpoint);
+
+/// 增量转换选项
+struct AppendOptions {
+    CsvEncoding encoding = CsvEncoding::Native;     ///< 仅在重建CSV时用于表头
+    std::function<void(uint64_t bytes, uint64_t rows)> progress;
+    /// 取消标志：追加数据前取消时 CSV 与断点保持不变，抛出 ParseCancelled
+    const std::atomic<bool> *cancel = nullptr;
+    /// 记录布局，空为默认布局；与断点记录的布局不同时整体重建
+    const RecordLayout *layout = nullptr;
+};
+
+/// 增量转换结果
+struct AppendStats {
+    uint64_t blocksDecoded = 0;
+    uint64_t rowsAppended = 0;
+    bool rebuilt = false;           ///< 断点不可用，已整体重新转换
+    bool upToDate = false;          ///< 输入自上次转换后没有变化
+};
+
+/**
+ * @brief appendBinToCsv
+ *  增量转换：根据断点只解析上次之后新增的块，去重后追加到已有 CSV 末尾，
+ *  并更新断点。结果与整体重新转换相同。
+ *  以下情况整体重建：没有断点或 CSV、输入变小或已被改写、记录布局改变、
+ *  新数据中出现早于 CSV 末行的时间戳（无法只靠追加保持有序）。
+ *  上次追加后未及写断点即中断时，CSV 多出的部分会先截掉。
+ *  重建失败或取消时原 CSV 保持不变，断点已删除，下次仍整体重建。
+ *  输入须为普通 .bin 文件：压缩输入、zip 项与标准输入抛出 std::runtime_error。
+ *  失败时抛出 std::runtime_error。
+ */
+AppendStats appendBinToCsv(const std::string &binFilename, const std::string &csvFilename,
+                           const AppendOptions &options = AppendOptions());
+
+#endif // INCREMENTAL_H
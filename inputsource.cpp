@@ -0,0 +1,749 @@
+#include "inputsource.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+#ifdef BINT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef BINT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// 后台解压每次产出的字节数与最多提前的块数
+static const size_t kReadAheadBytes = 1 << 20;
+static const size_t kReadAheadDepth = 4;
+// 压缩流的大小未记录在文件中，按此压缩率估计解析后的数据量（空白块多，压缩率通常更高）
+static const uint64_t kAssumedCompressionRatio = 8;
+
+static bool endsWithNoCase(const std::string &text, const char *suffix)
+{
+    size_t n = std::strlen(suffix);
+    if (text.size() < n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower((unsigned char)text[text.size() - n + i]) != suffix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool seekTo(FILE *fp, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(fp, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool splitZipEntryPath(const std::string &path, std::string &archive, std::string &entry)
+{
+    // 从左往右找第一个满足条件的'!'，包名本身可以含'!'
+    for (size_t pos = path.find('!'); pos != std::string::npos; pos = path.find('!', pos + 1)) {
+        std::string head = path.substr(0, pos);
+        std::error_code ec;
+        if (pos + 1 < path.size() && endsWithNoCase(head, ".zip") && fs::is_regular_file(head, ec)) {
+            archive = head;
+            entry = path.substr(pos + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+InputKind inputKindForPath(const std::string &path)
+{
+    if (path == "-") {
+        return InputKind::Stdin;
+    }
+    std::string archive, entry;
+    if (path.find('!') != std::string::npos && splitZipEntryPath(path, archive, entry)) {
+        return InputKind::ZipEntry;
+    }
+    if (endsWithNoCase(path, ".gz")) {
+        return InputKind::Gzip;
+    }
+    if (endsWithNoCase(path, ".zst")) {
+        return InputKind::Zstd;
+    }
+    return InputKind::File;
+}
+
+std::string inputBasePath(const std::string &path)
+{
+    std::string archive, entry;
+    switch (inputKindForPath(path)) {
+    case InputKind::Gzip:
+        return path.substr(0, path.size() - 3);
+    case InputKind::Zstd:
+        return path.substr(0, path.size() - 4);
+    case InputKind::ZipEntry:
+        splitZipEntryPath(path, archive, entry);
+        return (fs::path(archive).parent_path() / fs::path(entry).filename()).string();
+    case InputKind::Stdin:
+        return "stdin.bin";
+    case InputKind::File:
+        break;
+    }
+    return path;
+}
+
+// ---- zip 目录 ----
+
+static inline uint16_t le16(const unsigned char *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+static inline uint64_t le64(const unsigned char *p)
+{
+    return (uint64_t)le32(p) | ((uint64_t)le32(p + 4) << 32);
+}
+
+struct ZipEntryInfo {
+    std::string name;
+    uint16_t flags = 0;
+    uint16_t method = 0;            ///< 0 存储，8 deflate
+    uint64_t compressedSize = 0;
+    uint64_t size = 0;
+    uint64_t localOffset = 0;       ///< 本地文件头的偏移
+};
+
+static bool readAt(FILE *fp, uint64_t offset, void *buffer, size_t size)
+{
+    return seekTo(fp, offset) && std::fread(buffer, 1, size, fp) == size;
+}
+
+// 读出整个中央目录；支持 ZIP64
+static std::vector<ZipEntryInfo> readZipDirectory(FILE *fp, const std::string &archive)
+{
+    const std::string bad = "不是有效的 zip 文件：" + archive;
+    if (std::fseek(fp, 0, SEEK_END) != 0) {
+        throw std::runtime_error(bad);
+    }
+#ifdef _WIN32
+    uint64_t fileSize = (uint64_t)_ftelli64(fp);
+#else
+    uint64_t fileSize = (uint64_t)ftello(fp);
+#endif
+    // 目录结束记录在末尾 22 字节 + 最长 64KB 注释之内
+    size_t tailSize = (size_t)std::min<uint64_t>(fileSize, 22 + 0xFFFF);
+    std::vector<unsigned char> tail(tailSize);
+    if (tailSize < 22 || !readAt(fp, fileSize - tailSize, tail.data(), tailSize)) {
+        throw std::runtime_error(bad);
+    }
+    size_t eocd = tailSize - 22 + 1;
+    do {
+        --eocd;
+    } while (eocd > 0 && le32(&tail[eocd]) != 0x06054b50);
+    if (le32(&tail[eocd]) != 0x06054b50) {
+        throw std::runtime_error(bad);
+    }
+    uint64_t entryCount = le16(&tail[eocd + 10]);
+    uint64_t dirSize = le32(&tail[eocd + 12]);
+    uint64_t dirOffset = le32(&tail[eocd + 16]);
+    if (entryCount == 0xFFFF || dirSize == 0xFFFFFFFF || dirOffset == 0xFFFFFFFF) {
+        // ZIP64：结束记录前 20 字节为定位记录，指向 ZIP64 目录结束记录
+        uint64_t eocdPos = fileSize - tailSize + eocd;
+        unsigned char locator[20];
+        unsigned char eocd64[56];
+        if (eocdPos < 20 || !readAt(fp, eocdPos - 20, locator, sizeof(locator)) ||
+            le32(locator) != 0x07064b50 ||
+            !readAt(fp, le64(locator + 8), eocd64, sizeof(eocd64)) || le32(eocd64) != 0x06064b50) {
+            throw std::runtime_error(bad);
+        }
+        entryCount = le64(eocd64 + 32);
+        dirSize = le64(eocd64 + 40);
+        dirOffset = le64(eocd64 + 48);
+    }
+    if (dirOffset + dirSize > fileSize) {
+        throw std::runtime_error(bad);
+    }
+
+    std::vector<unsigned char> dir((size_t)dirSize);
+    if (dirSize > 0 && !readAt(fp, dirOffset, dir.data(), dir.size())) {
+        throw std::runtime_error(bad);
+    }
+    std::vector<ZipEntryInfo> entries;
+    size_t pos = 0;
+    for (uint64_t k = 0; k < entryCount; ++k) {
+        if (pos + 46 > dir.size() || le32(&dir[pos]) != 0x02014b50) {
+            throw std::runtime_error(bad);
+        }
+        const unsigned char *h = &dir[pos];
+        size_t nameLen = le16(h + 28);
+        size_t extraLen = le16(h + 30);
+        size_t commentLen = le16(h + 32);
+        if (pos + 46 + nameLen + extraLen + commentLen > dir.size()) {
+            throw std::runtime_error(bad);
+        }
+        ZipEntryInfo e;
+        e.flags = le16(h + 8);
+        e.method = le16(h + 10);
+        e.compressedSize = le32(h + 20);
+        e.size = le32(h + 24);
+        e.localOffset = le32(h + 42);
+        e.name.assign((const char *)h + 46, nameLen);
+        // ZIP64 扩展字段按顺序只含值为 0xFFFFFFFF 的几项
+        const unsigned char *x = h + 46 + nameLen;
+        const unsigned char *xEnd = x + extraLen;
+        while (x + 4 <= xEnd) {
+            uint16_t id = le16(x);
+            uint16_t len = le16(x + 2);
+            const unsigned char *v = x + 4;
+            const unsigned char *vEnd = std::min(v + len, xEnd);
+            if (id == 0x0001) {
+                if (e.size == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    e.size = le64(v);
+                    v += 8;
+                }
+                if (e.compressedSize == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    e.compressedSize = le64(v);
+                    v += 8;
+                }
+                if (e.localOffset == 0xFFFFFFFF && v + 8 <= vEnd) {
+                    e.localOffset = le64(v);
+                }
+            }
+            x += 4 + len;
+        }
+        entries.push_back(std::move(e));
+        pos += 46 + nameLen + extraLen + commentLen;
+    }
+    return entries;
+}
+
+static FILE *openArchive(const std::string &archive)
+{
+    FILE *fp = std::fopen(archive.c_str(), "rb");
+    if (!fp) {
+        throw std::runtime_error("无法打开文件：" + archive);
+    }
+    return fp;
+}
+
+std::vector<std::string> listZipBinEntries(const std::string &archive)
+{
+    FILE *fp = openArchive(archive);
+    std::vector<ZipEntryInfo> entries;
+    try {
+        entries = readZipDirectory(fp, archive);
+    } catch (...) {
+        std::fclose(fp);
+        throw;
+    }
+    std::fclose(fp);
+    std::vector<std::string> paths;
+    for (const ZipEntryInfo &e : entries) {
+        if (!e.name.empty() && e.name.back() != '/' && endsWithNoCase(e.name, ".bin")) {
+            paths.push_back(archive + "!" + e.name);
+        }
+    }
+    return paths;
+}
+
+static ZipEntryInfo findZipEntry(FILE *fp, const std::string &archive, const std::string &entry)
+{
+    for (ZipEntryInfo &e : readZipDirectory(fp, archive)) {
+        if (e.name == entry) {
+            return e;
+        }
+    }
+    throw std::runtime_error("zip 中没有该文件：" + archive + "!" + entry);
+}
+
+uint64_t estimatedInputBytes(const std::string &path)
+{
+    std::error_code ec;
+    switch (inputKindForPath(path)) {
+    case InputKind::File: {
+        uint64_t size = fs::file_size(path, ec);
+        return ec ? 0 : size;
+    }
+    case InputKind::Gzip:
+    case InputKind::Zstd: {
+        uint64_t size = fs::file_size(path, ec);
+        return ec ? 0 : size * kAssumedCompressionRatio;
+    }
+    case InputKind::ZipEntry: {
+        std::string archive, entry;
+        splitZipEntryPath(path, archive, entry);
+        try {
+            FILE *fp = openArchive(archive);
+            uint64_t size = 0;
+            try {
+                size = findZipEntry(fp, archive, entry).size;
+            } catch (const std::runtime_error &) {
+            }
+            std::fclose(fp);
+            return size;
+        } catch (const std::runtime_error &) {
+            return 0;
+        }
+    }
+    case InputKind::Stdin:
+        break;
+    }
+    return 0;
+}
+
+// ---- 各种输入流 ----
+
+bool InputSource::skip(uint64_t bytes)
+{
+    char scratch[64 * 1024];
+    while (bytes > 0) {
+        size_t n = read(scratch, (size_t)std::min<uint64_t>(bytes, sizeof(scratch)));
+        if (n == 0) {
+            return false;
+        }
+        bytes -= n;
+    }
+    return true;
+}
+
+size_t InputSource::readFully(void *buffer, size_t size)
+{
+    char *p = static_cast<char *>(buffer);
+    size_t done = 0;
+    while (done < size) {
+        size_t n = read(p + done, size - done);
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/// 普通文件（或标准输入）
+class FileSource : public InputSource
+{
+public:
+    FileSource(FILE *fp, const std::string &name, bool owned)
+        : m_fp(fp), m_name(name), m_owned(owned)
+    {
+    }
+    ~FileSource() override
+    {
+        if (m_owned) {
+            std::fclose(m_fp);
+        }
+    }
+
+    size_t read(void *buffer, size_t size) override
+    {
+        if (!m_owned) {
+            return readAvailable(buffer, size);
+        }
+        size_t n = std::fread(buffer, 1, size, m_fp);
+        if (n < size && std::ferror(m_fp)) {
+            throw std::runtime_error("读文件失败：" + m_name);
+        }
+        return n;
+    }
+
+    bool skip(uint64_t bytes) override
+    {
+        if (!m_owned) {
+            return InputSource::skip(bytes);   // 管道不能定位
+        }
+        // long 在部分平台只有32位，分段相对跳转；越过末尾时之后的读取返回0
+        const uint64_t kMaxStep = (uint64_t)1 << 30;
+        while (bytes > 0) {
+            uint64_t step = std::min(bytes, kMaxStep);
+            if (std::fseek(m_fp, (long)step, SEEK_CUR) != 0) {
+                return false;
+            }
+            bytes -= step;
+        }
+        return true;
+    }
+
+private:
+    // 管道只取已到达的数据，不等凑满 size（fread 会一直等到读满或管道关闭），
+    // 使预读线程能在两次读取之间响应停止
+    size_t readAvailable(void *buffer, size_t size)
+    {
+#ifdef _WIN32
+        int n = _read(_fileno(m_fp), buffer, (unsigned)std::min<size_t>(size, 1u << 30));
+#else
+        ssize_t n;
+        do {
+            n = ::read(fileno(m_fp), buffer, size);
+        } while (n < 0 && errno == EINTR);
+#endif
+        if (n < 0) {
+            throw std::runtime_error("读文件失败：" + m_name);
+        }
+        return (size_t)n;
+    }
+
+    FILE *m_fp;
+    std::string m_name;
+    bool m_owned;
+};
+
+/// zip 中的一项：存储的直接读出，deflate 的边读边解压
+class ZipEntrySource : public InputSource
+{
+public:
+    ZipEntrySource(const std::string &archive, const std::string &entry)
+        : m_name(archive + "!" + entry)
+    {
+        m_fp = openArchive(archive);
+        try {
+            ZipEntryInfo e = findZipEntry(m_fp, archive, entry);
+            if (e.flags & 1) {
+                throw std::runtime_error("不支持加密的 zip 项：" + m_name);
+            }
+            if (e.method != 0 && e.method != 8) {
+                throw std::runtime_error("不支持的 zip 压缩方式：" + m_name);
+            }
+            unsigned char local[30];
+            if (!readAt(m_fp, e.localOffset, local, sizeof(local)) || le32(local) != 0x04034b50 ||
+                !seekTo(m_fp, e.localOffset + 30 + le16(local + 26) + le16(local + 28))) {
+                throw std::runtime_error("不是有效的 zip 文件：" + archive);
+            }
+            m_remaining = e.compressedSize;
+            m_deflate = (e.method == 8);
+            if (m_deflate) {
+#ifdef BINT_HAVE_ZLIB
+                if (inflateInit2(&m_zs, -15) != Z_OK) {
+                    throw std::runtime_error("无法初始化解压：" + m_name);
+                }
+                m_inflating = true;
+                m_input.resize(kReadAheadBytes / 4);
+#else
+                throw std::runtime_error("本程序构建时未带 zlib 支持，无法读取：" + m_name);
+#endif
+            }
+        } catch (...) {
+            std::fclose(m_fp);
+            throw;
+        }
+    }
+
+    ~ZipEntrySource() override
+    {
+#ifdef BINT_HAVE_ZLIB
+        if (m_inflating) {
+            inflateEnd(&m_zs);
+        }
+#endif
+        std::fclose(m_fp);
+    }
+
+    size_t read(void *buffer, size_t size) override
+    {
+        if (!m_deflate) {
+            size_t n = std::fread(buffer, 1, (size_t)std::min<uint64_t>(size, m_remaining), m_fp);
+            if (n < size && std::ferror(m_fp)) {
+                throw std::runtime_error("读文件失败：" + m_name);
+            }
+            m_remaining -= n;
+            return n;
+        }
+#ifdef BINT_HAVE_ZLIB
+        size_t want = std::min<size_t>(size, 1u << 30);
+        m_zs.next_out = static_cast<Bytef *>(buffer);
+        m_zs.avail_out = (uInt)want;
+        while (m_zs.avail_out == want && !m_finished) {
+            if (m_zs.avail_in == 0) {
+                size_t n = (size_t)std::min<uint64_t>(m_input.size(), m_remaining);
+                if (n == 0 || std::fread(m_input.data(), 1, n, m_fp) != n) {
+                    throw std::runtime_error("zip 项不完整：" + m_name);
+                }
+                m_remaining -= n;
+                m_zs.next_in = m_input.data();
+                m_zs.avail_in = (uInt)n;
+            }
+            int rc = inflate(&m_zs, Z_NO_FLUSH);
+            if (rc == Z_STREAM_END) {
+                m_finished = true;
+            } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+                throw std::runtime_error("zip 项解压失败：" + m_name);
+            }
+        }
+        return want - m_zs.avail_out;
+#else
+        return 0;
+#endif
+    }
+
+private:
+    std::string m_name;
+    FILE *m_fp = nullptr;
+    uint64_t m_remaining = 0;       ///< 尚未读出的压缩数据字节
+    bool m_deflate = false;
+#ifdef BINT_HAVE_ZLIB
+    z_stream m_zs = {};
+    bool m_inflating = false;
+    bool m_finished = false;
+    std::vector<unsigned char> m_input;
+#endif
+};
+
+#ifdef BINT_HAVE_ZLIB
+/// gzip 流，连续的多个成员依次读出
+class GzipSource : public InputSource
+{
+public:
+    explicit GzipSource(const std::string &path)
+        : m_name(path)
+    {
+        m_gz = gzopen(path.c_str(), "rb");
+        if (!m_gz) {
+            throw std::runtime_error("无法打开文件：" + path);
+        }
+        gzbuffer(m_gz, 256 * 1024);
+    }
+    ~GzipSource() override { gzclose(m_gz); }
+
+    size_t read(void *buffer, size_t size) override
+    {
+        int n = gzread(m_gz, buffer, (unsigned)std::min<size_t>(size, 1u << 30));
+        if (n < 0) {
+            throw std::runtime_error("gzip 解压失败：" + m_name);
+        }
+        return (size_t)n;
+    }
+
+private:
+    std::string m_name;
+    gzFile m_gz = nullptr;
+};
+#endif
+
+#ifdef BINT_HAVE_ZSTD
+/// zstd 流，连续的多个帧依次读出
+class ZstdSource : public InputSource
+{
+public:
+    explicit ZstdSource(const std::string &path)
+        : m_name(path)
+    {
+        m_fp = std::fopen(path.c_str(), "rb");
+        if (!m_fp) {
+            throw std::runtime_error("无法打开文件：" + path);
+        }
+        m_stream = ZSTD_createDStream();
+        ZSTD_initDStream(m_stream);
+        m_input.resize(ZSTD_DStreamInSize());
+    }
+    ~ZstdSource() override
+    {
+        ZSTD_freeDStream(m_stream);
+        std::fclose(m_fp);
+    }
+
+    size_t read(void *buffer, size_t size) override
+    {
+        ZSTD_outBuffer out = { buffer, size, 0 };
+        while (out.pos == 0) {
+            if (m_in.pos == m_in.size) {
+                size_t n = std::fread(m_input.data(), 1, m_input.size(), m_fp);
+                if (n == 0) {
+                    if (std::ferror(m_fp) || m_frameOpen) {
+                        throw std::runtime_error("zstd 文件不完整：" + m_name);
+                    }
+                    return 0;
+                }
+                m_in = { m_input.data(), n, 0 };
+            }
+            size_t rc = ZSTD_decompressStream(m_stream, &out, &m_in);
+            if (ZSTD_isError(rc)) {
+                throw std::runtime_error("zstd 解压失败：" + m_name);
+            }
+            m_frameOpen = (rc != 0);
+        }
+        return out.pos;
+    }
+
+private:
+    std::string m_name;
+    FILE *m_fp = nullptr;
+    ZSTD_DStream *m_stream = nullptr;
+    std::vector<char> m_input;
+    ZSTD_inBuffer m_in = { nullptr, 0, 0 };
+    bool m_frameOpen = false;       ///< 当前帧尚未结束
+};
+#endif
+
+/**
+ * 在后台线程上提前读取（解压）内层流，每块最多 kReadAheadBytes，最多提前 kReadAheadDepth 块，
+ * 解压与调用方的解码重叠。内层流的异常在调用方下一次读到该处时抛出。
+ * 每块只调用一次内层流的 read，管道上已到达的数据立即交出；出错或取消后析构最多等
+ * 这一次 read 返回，标准输入的上游长时间不写也不关闭时，仍要等到它下次写入或关闭管道。
+ */
+class ReadAheadSource : public InputSource
+{
+public:
+    explicit ReadAheadSource(std::unique_ptr<InputSource> inner)
+        : m_inner(std::move(inner))
+    {
+        m_thread = std::thread([this]{ run(); });
+    }
+
+    ~ReadAheadSource() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_changed.notify_all();
+        }
+        m_thread.join();
+    }
+
+    size_t read(void *buffer, size_t size) override
+    {
+        if (size == 0) {
+            return 0;
+        }
+        if (m_pos == m_chunk.size() && !nextChunk()) {
+            return 0;
+        }
+        size_t n = std::min(size, m_chunk.size() - m_pos);
+        std::memcpy(buffer, m_chunk.data() + m_pos, n);
+        m_pos += n;
+        return n;
+    }
+
+private:
+    bool nextChunk()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]{ return !m_ready.empty() || m_done; });
+        if (m_ready.empty()) {
+            if (m_error) {
+                std::rethrow_exception(m_error);
+            }
+            return false;
+        }
+        m_free.push_back(std::move(m_chunk));
+        m_chunk = std::move(m_ready.front());
+        m_ready.pop_front();
+        m_pos = 0;
+        m_changed.notify_all();
+        return true;
+    }
+
+    void run()
+    {
+        try {
+            while (true) {
+                std::vector<char> chunk;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_changed.wait(lock, [this]{
+                        return m_stopping || m_ready.size() < kReadAheadDepth;
+                    });
+                    if (m_stopping) {
+                        break;
+                    }
+                    if (!m_free.empty()) {
+                        chunk = std::move(m_free.back());
+                        m_free.pop_back();
+                    }
+                }
+                chunk.resize(kReadAheadBytes);
+                // 只读一次，不凑满：管道读到多少交出多少，之后回到上面检查是否停止
+                size_t n;
+                {
+                    PerfTimer timer(PerfStage::Read);
+                    n = m_inner->read(chunk.data(), chunk.size());
+                }
+                if (n == 0) {
+                    break;
+                }
+                chunk.resize(n);
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_ready.push_back(std::move(chunk));
+                m_changed.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = std::current_exception();
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done = true;
+        m_changed.notify_all();
+    }
+
+    std::unique_ptr<InputSource> m_inner;
+    std::vector<char> m_chunk;          ///< 调用方正在读的块
+    size_t m_pos = 0;
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<std::vector<char>> m_ready;
+    std::vector<std::vector<char>> m_free;
+    std::exception_ptr m_error;
+    bool m_done = false;
+    bool m_stopping = false;
+};
+
+std::unique_ptr<InputSource> openInputSource(const std::string &path)
+{
+    std::unique_ptr<InputSource> source;
+    std::string archive, entry;
+    switch (inputKindForPath(path)) {
+    case InputKind::File: {
+        FILE *fp = std::fopen(path.c_str(), "rb");
+        if (!fp) {
+            throw std::runtime_error("无法打开文件：" + path);
+        }
+        // 普通文件由系统预读，不必另开线程
+        return std::unique_ptr<InputSource>(new FileSource(fp, path, true));
+    }
+    case InputKind::Stdin:
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+        source.reset(new FileSource(stdin, "<stdin>", false));
+        break;
+    case InputKind::Gzip:
+#ifdef BINT_HAVE_ZLIB
+        source.reset(new GzipSource(path));
+        break;
+#else
+        throw std::runtime_error("本程序构建时未带 zlib 支持，无法读取：" + path);
+#endif
+    case InputKind::Zstd:
+#ifdef BINT_HAVE_ZSTD
+        source.reset(new ZstdSource(path));
+        break;
+#else
+        throw std::runtime_error("本程序构建时未带 zstd 支持，无法读取：" + path);
+#endif
+    case InputKind::ZipEntry:
+        splitZipEntryPath(path, archive, entry);
+        source.reset(new ZipEntrySource(archive, entry));
+        break;
+    }
+    return std::unique_ptr<InputSource>(new ReadAheadSource(std::move(source)));
+}
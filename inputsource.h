@@ -0,0 +1,62 @@
+#ifndef INPUTSOURCE_H
+#define INPUTSOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// 输入路径的种类，由 inputKindForPath 按路径判断
+enum class InputKind {
+    File,       ///< 普通文件，可内存映射
+    Gzip,       ///< .gz，可含多个 gzip 成员
+    Zstd,       ///< .zst，可含多个 zstd 帧
+    ZipEntry,   ///< zip 压缩包中的一项，路径写作 <压缩包.zip>!<项名>
+    Stdin,      ///< "-"，标准输入
+};
+
+/// 路径的输入种类：zip 项要求 '!' 前是以 .zip 结尾的已有文件
+InputKind inputKindForPath(const std::string &path);
+
+/// 拆开 zip 项路径；不是 zip 项时返回 false
+bool splitZipEntryPath(const std::string &path, std::string &archive, std::string &entry);
+
+/// zip 压缩包中文件名以 .bin 结尾的各项，返回 <压缩包>!<项名> 形式的路径（按包内顺序）；
+/// 压缩包无法读取时抛出 std::runtime_error
+std::vector<std::string> listZipBinEntries(const std::string &archive);
+
+/// 去掉压缩后缀与 zip 包名后的显示路径，用于生成输出文件名：
+/// a/x.bin.gz -> a/x.bin，a/p.zip!d/x.bin -> a/x.bin
+std::string inputBasePath(const std::string &path);
+
+/// 解析后的数据量估计（字节）：普通文件与 zip 项为实际大小，
+/// gzip / zstd 按压缩率估计，标准输入为0；无法取得时返回0
+uint64_t estimatedInputBytes(const std::string &path);
+
+/**
+ * @brief InputSource
+ *  只能向前读的字节流。BinBlockReader 不能内存映射时从它读取：
+ *  普通文件、gzip / zstd 流、zip 项与标准输入，按路径由 openInputSource 选择；
+ *  解压缩在后台线程上提前进行，与解码重叠。读取失败抛出 std::runtime_error。
+ */
+class InputSource
+{
+public:
+    virtual ~InputSource() {}
+
+    /// 读最多 size 字节，返回实际读到的字节数；0 表示已到末尾。
+    /// 未到末尾时可能少于 size，readFully 会读满
+    virtual size_t read(void *buffer, size_t size) = 0;
+
+    /// 向前跳过 bytes 字节；不足时停在末尾并返回 false。默认读出后丢弃
+    virtual bool skip(uint64_t bytes);
+
+    /// 读满 size 字节（到末尾为止），返回实际字节数
+    size_t readFully(void *buffer, size_t size);
+};
+
+/// 按路径打开输入流；无法打开时抛出 std::runtime_error
+std::unique_ptr<InputSource> openInputSource(const std::string &path);
+
+#endif // INPUTSOURCE_H
@@ -1,4 +1,5 @@
 #include <QApplication>
+#include <QTimer>
 #include "mainwindow.h"
 
 int main(int argc, char *argv[])
@@ -6,5 +7,9 @@ int main(int argc, char *argv[])
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
+    // 显示主窗口后即退出，供 bint-bench 测量启动耗时
+    if (a.arguments().contains(QStringLiteral("--quit-after-show"))) {
+        QTimer::singleShot(0, &a, &QCoreApplication::quit);
+    }
     return a.exec();
 }
@@ -1,8 +1,18 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QCloseEvent>
+#include <QHeaderView>
+#include <QLabel>
 #include <QMessageBox>
+#include <QStatusBar>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
 #include "parsebin.h"
+#include "inputsource.h"
+#include "previewmodel.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -13,35 +23,110 @@ MainWindow::MainWindow(QWidget *parent)
     // 连接信号与槽
     connect(ui->btnSelect, &QPushButton::clicked, this, &MainWindow::onSelectBinFiles);
     connect(ui->btnParse,  &QPushButton::clicked, this, &MainWindow::onParse);
+    connect(ui->btnCancel, &QPushButton::clicked, this, &MainWindow::onCancel);
 
     // 默认选中“分别输出CSV”
     ui->radioSeparate->setChecked(true);
+
+    // 进度：千分比，避免大文件字节数溢出 int
+    ui->progressBar->setRange(0, 1000);
+    ui->progressBar->setValue(0);
+    ui->btnCancel->setEnabled(false);
+
+    // 预览选中的文件：行高固定，视图不必逐行测量即可定位任意行
+    m_previewModel = new PreviewModel(this);
+    ui->tablePreview->setModel(m_previewModel);
+    ui->tablePreview->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    connect(ui->listWidget, &QListWidget::currentRowChanged, this, &MainWindow::onPreviewFile);
+
+    m_statusLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_statusLabel);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(200);
+    connect(m_progressTimer, &QTimer::timeout, this, &MainWindow::onProgressTick);
 }
 
 MainWindow::~MainWindow()
 {
+    if (m_worker) {
+        m_cancel = true;
+        m_worker->wait();
+    }
     delete ui;
 }
 
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    // 转换中关闭窗口：先请求取消并等待工作线程退出，不留下半截CSV
+    if (m_worker) {
+        m_cancel = true;
+        statusBar()->showMessage(tr("正在取消..."));
+        m_worker->wait();
+    }
+    QMainWindow::closeEvent(event);
+}
+
+void MainWindow::setBusy(bool busy)
+{
+    ui->btnSelect->setEnabled(!busy);
+    ui->btnParse->setEnabled(!busy);
+    ui->radioSeparate->setEnabled(!busy);
+    ui->radioMerge->setEnabled(!busy);
+    ui->checkUtf8Bom->setEnabled(!busy);
+    ui->btnCancel->setEnabled(busy);
+}
+
 void MainWindow::onSelectBinFiles()
 {
     QStringList paths = QFileDialog::getOpenFileNames(
         this,
         tr("选择 .bin 文件"),
         QString(),
-        tr("BIN Files (*.bin);;All Files (*.*)"));
+        tr("BIN Files (*.bin *.bin.gz *.bin.zst *.zip);;All Files (*.*)"));
     if (paths.isEmpty()) {
         return;
     }
-    // 显示到 listWidget
+    // 显示到 listWidget；zip 压缩包展开为包内的各个 .bin
+    m_previewModel->clear();
     ui->listWidget->clear();
     for (const QString &p : paths) {
-        ui->listWidget->addItem(p);
+        if (QFileInfo(p).suffix().toLower() != "zip") {
+            ui->listWidget->addItem(p);
+            continue;
+        }
+        try {
+            for (const std::string &entry : listZipBinEntries(p.toStdString())) {
+                ui->listWidget->addItem(QString::fromStdString(entry));
+            }
+        } catch (const std::exception &e) {
+            QMessageBox::warning(this, tr("提示"), QString::fromStdString(e.what()));
+        }
+    }
+}
+
+void MainWindow::onPreviewFile(int row)
+{
+    if (row < 0) {
+        m_previewModel->clear();
+        return;
+    }
+    QString path = ui->listWidget->item(row)->text();
+    try {
+        m_previewModel->open(path.toStdString());
+    } catch (const std::exception &e) {
+        // 压缩输入等不能预览，不影响转换
+        m_previewModel->clear();
+        statusBar()->showMessage(QString::fromStdString(e.what()), 5000);
     }
 }
 
 void MainWindow::onParse()
 {
+    if (m_worker) {
+        return; // 已有转换在进行
+    }
+
     int count = ui->listWidget->count();
     if (count == 0) {
         QMessageBox::warning(this, tr("提示"), tr("尚未选择任何 .bin 文件！"));
@@ -50,72 +135,152 @@ void MainWindow::onParse()
 
     // 判断是“合并输出”还是“分别输出”
     bool mergeToOne = ui->radioMerge->isChecked();
+    CsvEncoding encoding = ui->checkUtf8Bom->isChecked() ? CsvEncoding::Utf8Bom
+                                                          : CsvEncoding::Native;
 
-    // 收集列表中文件路径
-    QStringList binPaths;
+    // 收集列表中文件路径，同时统计总字节数作为进度基准
+    std::vector<std::string> binPaths;
+    uint64_t bytesTotal = 0;
     for (int i = 0; i < count; ++i) {
-        binPaths << ui->listWidget->item(i)->text();
+        QString path = ui->listWidget->item(i)->text();
+        binPaths.push_back(path.toStdString());
+        bytesTotal += estimatedInputBytes(binPaths.back());
     }
 
+    QString outFilename;
     if (mergeToOne) {
         // 让用户选择合并后CSV的保存路径
-        QString outFilename = QFileDialog::getSaveFileName(
+        outFilename = QFileDialog::getSaveFileName(
             this,
             tr("保存合并后的 CSV"),
             QString(),
-            tr("CSV Files (*.csv);;All Files (*.*)"));
+            tr("CSV Files (*.csv);;Arrow IPC / Feather (*.arrow *.feather);;"
+               "Compressed CSV (*.csv.gz *.csv.zst);;All Files (*.*)"));
         if (outFilename.isEmpty()) {
             return; // 用户取消
         }
+    }
+    // 按后缀选择输出格式（.gz / .zst 之前的后缀），分别输出时总是 CSV
+    OutputFormat format = OutputFormat::Csv;
+    QString baseName = outFilename;
+    if (compressionForPath(outFilename.toStdString()) != OutputCompression::None) {
+        baseName = QFileInfo(outFilename).completeBaseName();
+    }
+    QString suffix = QFileInfo(baseName).suffix().toLower();
+    if (suffix == "arrow" || suffix == "feather") {
+        format = OutputFormat::Arrow;
+    }
 
-        std::vector<Record> mergedRecords;
-        // 解析所有 bin
-        for (const QString &binPath : binPaths) {
-            try {
-                std::vector<Record> recs = parseBinFile(binPath.toStdString());
-                mergedRecords.insert(mergedRecords.end(), recs.begin(), recs.end());
-            } catch (const std::exception &e) {
-                QMessageBox::critical(this, tr("错误"),
-                                      tr("解析失败：%1\n%2").arg(binPath, e.what()));
-                return;
-            }
-        }
-        // 写入CSV
-        try {
-            writeCsv(outFilename.toStdString(), mergedRecords);
-        } catch (const std::exception &e) {
-            QMessageBox::critical(this, tr("错误"),
-                                  tr("写CSV失败：\n%1").arg(e.what()));
-            return;
+    m_mergeToOne = mergeToOne;
+    m_outFilename = outFilename;
+    m_bytesTotal = bytesTotal;
+    m_bytesDone = 0;
+    m_rowsDone = 0;
+    m_cancel = false;
+    m_report = ConversionReport();
+
+    // 转换放到工作线程，界面保持响应；各文件在调度器线程池上并行
+    std::string csvFilename = outFilename.toStdString();
+    m_worker = QThread::create([this, binPaths, csvFilename, mergeToOne, encoding, format]{
+        ConversionOptions options;
+        options.format = format;
+        options.encoding = encoding;
+        options.cancel = &m_cancel;
+        options.progress = [this](uint64_t bytes, uint64_t rows){
+            m_bytesDone.fetch_add(bytes, std::memory_order_relaxed);
+            m_rowsDone.fetch_add(rows, std::memory_order_relaxed);
+        };
+        if (mergeToOne) {
+            // 各文件并行解析，按时间归并写出
+            m_report = m_scheduler.convertMerged(binPaths, csvFilename, options);
+        } else {
+            // 分别输出，各文件并行转换
+            m_report = m_scheduler.convertSeparate(binPaths, options);
         }
+    });
+    connect(m_worker, &QThread::finished, this, &MainWindow::onConversionFinished);
 
+    setBusy(true);
+    ui->progressBar->setValue(0);
+    statusBar()->showMessage(tr("正在转换..."));
+    m_elapsed.start();
+    m_progressTimer->start();
+    m_worker->start();
+}
+
+void MainWindow::onCancel()
+{
+    if (m_worker) {
+        m_cancel = true;
+        ui->btnCancel->setEnabled(false);
+        statusBar()->showMessage(tr("正在取消..."));
+    }
+}
+
+void MainWindow::onProgressTick()
+{
+    uint64_t bytes = m_bytesDone.load(std::memory_order_relaxed);
+    uint64_t rows = m_rowsDone.load(std::memory_order_relaxed);
+    if (m_bytesTotal > 0) {
+        ui->progressBar->setValue((int)std::min<uint64_t>(1000, bytes * 1000 / m_bytesTotal));
+    }
+
+    // 实时吞吐
+    double seconds = m_elapsed.elapsed() / 1000.0;
+    if (seconds > 0) {
+        m_statusLabel->setText(tr("%1 MB/s，%2 行/s")
+                                   .arg(bytes / (1024.0 * 1024.0) / seconds, 0, 'f', 1)
+                                   .arg(rows / seconds, 0, 'f', 0));
+    }
+}
+
+void MainWindow::onConversionFinished()
+{
+    m_progressTimer->stop();
+    onProgressTick();
+    m_worker->deleteLater();
+    m_worker = nullptr;
+    setBusy(false);
+
+    const ConversionReport &report = m_report;
+    if (report.cancelled) {
+        ui->progressBar->setValue(0);
+        statusBar()->showMessage(tr("已取消"), 5000);
+    } else {
+        ui->progressBar->setValue(1000);
+        statusBar()->showMessage(tr("完成，用时 %1 秒").arg(m_elapsed.elapsed() / 1000.0, 0, 'f', 1));
+    }
+
+    if (m_mergeToOne && report.errors.empty() && !report.cancelled) {
         QMessageBox::information(this, tr("完成"),
-                                 tr("合并输出成功，已生成：\n%1").arg(outFilename));
-    }
-    else {
-        // 分别输出
-        QStringList successList;
-        for (const QString &binPath : binPaths) {
-            try {
-                std::vector<Record> recs = parseBinFile(binPath.toStdString());
-                // 生成同名 .csv (仅替换后缀)
-                QString csvPath = binPath;
-                int dotPos = csvPath.lastIndexOf('.');
-                if (dotPos > 0) {
-                    csvPath = csvPath.left(dotPos) + ".csv";
-                } else {
-                    csvPath += ".csv";
-                }
-                writeCsv(csvPath.toStdString(), recs);
-                successList << csvPath;
-            } catch (const std::exception &e) {
-                QMessageBox::critical(this, tr("错误"),
-                                      tr("解析失败：%1\n%2").arg(binPath, e.what()));
-            }
+                                 tr("合并输出成功，已生成：\n%1").arg(m_outFilename));
+        return;
+    }
+
+    // 汇总结果，失败的文件一次性列出
+    QStringList successList;
+    for (const std::string &csvPath : report.csvFiles) {
+        successList << QString::fromStdString(csvPath);
+    }
+    QStringList errorList;
+    for (const ConversionError &err : report.errors) {
+        errorList << tr("%1\n%2").arg(QString::fromStdString(err.binPath),
+                                      QString::fromStdString(err.message));
+    }
+
+    if (!errorList.isEmpty()) {
+        QString text = tr("解析失败：\n%1").arg(errorList.join("\n"));
+        if (!successList.isEmpty()) {
+            text += tr("\n\n生成的CSV文件：\n%1").arg(successList.join("\n"));
         }
+        QMessageBox::critical(this, tr("错误"), text);
+    } else if (report.cancelled) {
         if (!successList.isEmpty()) {
-            QMessageBox::information(this, tr("完成"),
-                                     tr("处理完成！生成的CSV文件：\n%1").arg(successList.join("\n")));
+            QMessageBox::information(this, tr("已取消"),
+                                     tr("转换已取消。取消前已生成的CSV文件：\n%1").arg(successList.join("\n")));
         }
+    } else if (!successList.isEmpty()) {
+        QMessageBox::information(this, tr("完成"),
+                                 tr("处理完成！生成的CSV文件：\n%1").arg(successList.join("\n")));
     }
 }
@@ -2,6 +2,17 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <cstdint>
+
+#include "converter.h"
+
+class QThread;
+class QTimer;
+class QLabel;
+class PreviewModel;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -17,13 +28,37 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private slots:
     // 确保这两个函数声明和 mainwindow.cpp 中的实现同名
     void onSelectBinFiles();
     void onParse();
+    void onCancel();
+    void onProgressTick();
+    void onConversionFinished();
+    void onPreviewFile(int row);
 
 private:
+    void setBusy(bool busy);
+
     Ui::MainWindow *ui;
+    ConversionScheduler m_scheduler;  // 常驻线程池，多次转换复用
+
+    // 后台转换状态：工作线程只写原子计数，界面由定时器轮询刷新
+    QThread *m_worker = nullptr;
+    QTimer *m_progressTimer = nullptr;
+    QLabel *m_statusLabel = nullptr;
+    PreviewModel *m_previewModel = nullptr;
+    QElapsedTimer m_elapsed;
+    std::atomic<bool> m_cancel{false};
+    std::atomic<uint64_t> m_bytesDone{0};
+    std::atomic<uint64_t> m_rowsDone{0};
+    uint64_t m_bytesTotal = 0;
+    bool m_mergeToOne = false;
+    QString m_outFilename;
+    ConversionReport m_report;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,181 @@
+#include "mappedfile.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/vfs.h>
+#endif
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+// 网络共享上的映射在断线时会触发访问异常，交给 fread 路径处理
+static bool isRemotePath(const std::string &filename)
+{
+    if (filename.size() >= 2 &&
+        (filename[0] == '\\' || filename[0] == '/') &&
+        (filename[1] == '\\' || filename[1] == '/')) {
+        return true; // UNC 路径
+    }
+    if (filename.size() >= 2 && filename[1] == ':') {
+        char root[4] = { filename[0], ':', '\\', '\0' };
+        return GetDriveTypeA(root) == DRIVE_REMOTE;
+    }
+    return false;
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+    if (isRemotePath(filename)) {
+        return false;
+    }
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                              NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &fileSize) ||
+        fileSize.QuadPart <= 0 || (unsigned long long)fileSize.QuadPart > (size_t)-1) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char *>(view);
+    m_size = (size_t)fileSize.QuadPart;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle((HANDLE)m_mapping);
+    }
+    if (m_file) {
+        CloseHandle((HANDLE)m_file);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::advise(size_t, size_t, bool)
+{
+    // Windows 的映射预读不可调，按默认策略
+}
+
+#else
+
+// 网络文件系统上的映射在断线时会触发 SIGBUS，交给 fread 路径处理
+static bool isRemoteFs(int fd)
+{
+#if defined(__linux__)
+    struct statfs fs;
+    if (fstatfs(fd, &fs) != 0) {
+        return true;
+    }
+    switch ((unsigned long)fs.f_type) {
+    case 0x6969UL:      // NFS
+    case 0x517BUL:      // SMB
+    case 0xFF534D42UL:  // CIFS
+    case 0xFE534D42UL:  // SMB2
+    case 0x65735546UL:  // FUSE
+        return true;
+    default:
+        return false;
+    }
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+    close();
+
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+        (unsigned long long)st.st_size > (size_t)-1 || isRemoteFs(fd)) {
+        ::close(fd);
+        return false;
+    }
+
+    void *addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // 映射建立后即可关闭描述符
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+#if defined(POSIX_MADV_SEQUENTIAL)
+    posix_madvise(addr, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    m_data = static_cast<const unsigned char *>(addr);
+    m_size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+void MappedFile::advise(size_t offset, size_t length, bool sequential)
+{
+    if (!m_data || offset >= m_size) {
+        return;
+    }
+    // 起点须按页对齐
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t begin = offset / page * page;
+    length = std::min(length, m_size - offset) + (offset - begin);
+#if defined(POSIX_MADV_SEQUENTIAL) && defined(POSIX_MADV_RANDOM)
+    posix_madvise(const_cast<unsigned char *>(m_data) + begin, length,
+                  sequential ? POSIX_MADV_SEQUENTIAL : POSIX_MADV_RANDOM);
+#else
+    (void)length;
+    (void)sequential;
+#endif
+}
+
+#endif
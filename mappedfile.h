@@ -0,0 +1,43 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief MappedFile
+ *  只读内存映射整个文件（POSIX mmap / Win32 MapViewOfFile）。
+ *  管道、网络共享、空文件等不适合映射的情况 open() 返回 false，
+ *  调用方应回退到 fread 逐块读取。
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /// 映射文件，成功返回 true；失败时对象保持未打开状态
+    bool open(const std::string &filename);
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    const unsigned char *data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    /// 访问方式提示：sequential 为 false 时按随机访问处理 [offset, offset+length)，
+    /// 不做大段预读。打开时整个文件按顺序访问提示
+    void advise(size_t offset, size_t length, bool sequential);
+
+private:
+    const unsigned char *m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;     // HANDLE
+    void *m_mapping = nullptr;  // HANDLE
+#endif
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,314 @@
+#include "outputfile.h"
+#include "perfstats.h"
+#include "recyclepool.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#ifdef BINT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef BINT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// 压缩时每个文件最多在途的块数（含正在写出的），限制多个文件同时输出时的内存
+static const size_t kMaxCompressDepth = 4;
+// 浮点文本在 zlib 默认级别下只有约 10MB/s，取最快级别（体积约大 15%）；zstd 3 级又快又小
+static const int kGzipLevel = 1;
+static const int kZstdLevel = 3;
+
+// 缓冲在文件关闭后归还，下一个输出文件直接复用（并行写出时各取若干块）
+static RecyclePool<std::vector<char>> &bufferPool()
+{
+    static RecyclePool<std::vector<char>> pool(16, 16 * kOutputBlockBytes);
+    return pool;
+}
+
+// 所有输出文件共享的压缩线程，按硬件线程数
+static ThreadPool &compressPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+static std::vector<char> acquireBuffer()
+{
+    std::vector<char> buffer = bufferPool().acquire();
+    buffer.resize(kOutputBlockBytes);
+    return buffer;
+}
+
+static bool endsWith(const std::string &text, const char *suffix)
+{
+    size_t n = std::char_traits<char>::length(suffix);
+    if (text.size() < n) {
+        return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (std::tolower((unsigned char)text[text.size() - n + i]) != suffix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+OutputCompression compressionForPath(const std::string &filename)
+{
+    if (endsWith(filename, ".gz")) {
+        return OutputCompression::Gzip;
+    }
+    if (endsWith(filename, ".zst")) {
+        return OutputCompression::Zstd;
+    }
+    return OutputCompression::None;
+}
+
+const char *compressionExtension(OutputCompression compression)
+{
+    switch (compression) {
+    case OutputCompression::Gzip:
+        return ".gz";
+    case OutputCompression::Zstd:
+        return ".zst";
+    case OutputCompression::None:
+        break;
+    }
+    return "";
+}
+
+bool compressionAvailable(OutputCompression compression)
+{
+    switch (compression) {
+    case OutputCompression::Gzip:
+#ifdef BINT_HAVE_ZLIB
+        return true;
+#else
+        return false;
+#endif
+    case OutputCompression::Zstd:
+#ifdef BINT_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case OutputCompression::None:
+        break;
+    }
+    return true;
+}
+
+#ifdef BINT_HAVE_ZLIB
+// 压缩为一个完整的 gzip 成员
+static bool compressGzip(const char *data, size_t size, std::vector<char> &out)
+{
+    z_stream zs = {};
+    if (deflateInit2(&zs, kGzipLevel, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out.resize(deflateBound(&zs, (uLong)size));
+    zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zs.avail_in = (uInt)size;
+    zs.next_out = reinterpret_cast<Bytef *>(out.data());
+    zs.avail_out = (uInt)out.size();
+    int rc = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return rc == Z_STREAM_END;
+}
+#endif
+
+#ifdef BINT_HAVE_ZSTD
+// 压缩为一个完整的 zstd 帧（帧头含原始大小）
+static bool compressZstd(const char *data, size_t size, std::vector<char> &out)
+{
+    out.resize(ZSTD_compressBound(size));
+    size_t n = ZSTD_compress(out.data(), out.size(), data, size, kZstdLevel);
+    if (ZSTD_isError(n)) {
+        return false;
+    }
+    out.resize(n);
+    return true;
+}
+#endif
+
+OutputFile::~OutputFile()
+{
+    if (m_fp) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_discard = true;
+        }
+        stopWriter();
+        std::fclose(m_fp);
+        m_fp = nullptr;
+        if (!m_append) {
+            std::remove(m_path.c_str());
+        }
+    }
+    bufferPool().release(std::move(m_current));
+}
+
+bool OutputFile::open(const std::string &filename, bool append)
+{
+    m_compression = compressionForPath(filename);
+    if (!compressionAvailable(m_compression)) {
+        throw std::runtime_error(std::string("本程序构建时未带 ") +
+                                 (m_compression == OutputCompression::Gzip ? "zlib" : "zstd") +
+                                 " 支持，无法写出：" + filename);
+    }
+    m_filename = filename;
+    m_path = append ? filename : filename + ".tmp";
+    m_append = append;
+    m_fp = std::fopen(m_path.c_str(), append ? "ab" : "wb");
+    if (!m_fp) {
+        return false;
+    }
+    // 每次都是整块写出，stdio 的缓冲只会多一次复制
+    std::setvbuf(m_fp, nullptr, _IONBF, 0);
+
+    // 不压缩时一块写出、一块填充；压缩时压缩线程各处理一块
+    m_depth = 1;
+    if (m_compression != OutputCompression::None) {
+        m_depth = std::max<size_t>(2, std::min<size_t>(compressPool().size(), kMaxCompressDepth));
+    }
+    m_current = acquireBuffer();
+    m_writer = std::thread([this]{ run(); });
+    return true;
+}
+
+void OutputFile::compress(Block &block)
+{
+    bool skip;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        skip = m_discard || m_failed;
+    }
+    bool ok = true;
+    if (!skip) {
+        PerfTimer timer(PerfStage::Compress);
+        block.packed = bufferPool().acquire();
+        switch (m_compression) {
+#ifdef BINT_HAVE_ZLIB
+        case OutputCompression::Gzip:
+            ok = compressGzip(block.data.data(), block.size, block.packed);
+            break;
+#endif
+#ifdef BINT_HAVE_ZSTD
+        case OutputCompression::Zstd:
+            ok = compressZstd(block.data.data(), block.size, block.packed);
+            break;
+#endif
+        default:
+            ok = false;
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    block.failed = !ok;
+    block.ready = true;
+    m_changed.notify_all();
+}
+
+void OutputFile::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_changed.wait(lock, [this]{
+            return m_queue.empty() ? m_stopping : m_queue.front()->ready;
+        });
+        if (m_queue.empty()) {
+            return;
+        }
+        // 只有本线程移除队首，解锁后其他线程只会在队尾追加
+        Block &block = *m_queue.front();
+        bool skip = m_failed || m_discard;
+        lock.unlock();
+        bool ok = !block.failed;
+        if (ok && !skip) {
+            const std::vector<char> &bytes =
+                    m_compression == OutputCompression::None ? block.data : block.packed;
+            size_t size = m_compression == OutputCompression::None ? block.size : bytes.size();
+            PerfTimer timer(PerfStage::Write);
+            perfCount(PerfCounter::OutputBytes, size);
+            ok = std::fwrite(bytes.data(), 1, size, m_fp) == size;
+        }
+        bufferPool().release(std::move(block.data));
+        bufferPool().release(std::move(block.packed));
+        lock.lock();
+        if (!ok) {
+            m_failed = true;
+        }
+        m_queue.pop_front();
+        m_changed.notify_all();
+    }
+}
+
+bool OutputFile::submit(size_t size)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]{ return m_queue.size() < m_depth; });
+    if (m_failed) {
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+    std::unique_ptr<Block> block(new Block);
+    block->data = std::move(m_current);
+    block->size = size;
+    block->ready = (m_compression == OutputCompression::None);
+    Block *pending = block.get();
+    m_queue.push_back(std::move(block));
+    m_changed.notify_all();
+    lock.unlock();
+
+    if (m_compression != OutputCompression::None) {
+        compressPool().submit([this, pending]{ compress(*pending); });
+    }
+    m_current = acquireBuffer();
+    return true;
+}
+
+void OutputFile::stopWriter()
+{
+    if (!m_writer.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_changed.notify_all();
+    }
+    m_writer.join();
+}
+
+bool OutputFile::close()
+{
+    if (!m_fp) {
+        return false;
+    }
+    stopWriter();
+    FILE *fp = m_fp;
+    m_fp = nullptr;
+    bool ok = std::fclose(fp) == 0 && !m_failed;
+    if (!m_append) {
+        std::error_code ec;
+        if (ok) {
+            fs::rename(m_path, m_filename, ec);
+        }
+        if (!ok || ec) {
+            std::remove(m_path.c_str());
+            return false;
+        }
+    }
+    return ok;
+}
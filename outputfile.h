@@ -0,0 +1,101 @@
+#ifndef OUTPUTFILE_H
+#define OUTPUTFILE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// OutputFile 每块缓冲的字节数，也是除最后一块外每次写请求（或压缩帧）的原始大小
+static const size_t kOutputBlockBytes = 4 << 20;
+
+/// 输出文件的压缩方式
+enum class OutputCompression {
+    None,
+    Gzip,   ///< .gz，每块一个 gzip 成员，gzip -d / zcat / pandas 可直接读取
+    Zstd,   ///< .zst，每块一个 zstd 帧，zstd -d / zstdcat 可直接读取
+};
+
+/// 按文件名后缀（.gz / .zst，不区分大小写）判断压缩方式
+OutputCompression compressionForPath(const std::string &filename);
+/// 压缩方式对应的文件后缀（含'.'），不压缩时为空串
+const char *compressionExtension(OutputCompression compression);
+/// 本程序构建时是否带有该压缩方式（zlib / libzstd 均为可选依赖）
+bool compressionAvailable(OutputCompression compression);
+
+/**
+ * @brief OutputFile
+ *  异步输出文件：调用方把数据写进 buffer()，写满后 submit() 交给后台写出，
+ *  随即换到另一块缓冲继续写，格式化与磁盘（或网络共享）写入重叠进行。
+ *  每次写请求都是整块 kOutputBlockBytes（最后一块除外），不经 stdio 缓冲，
+ *  网络共享上只有少量大块写。
+ *  文件名以 .gz / .zst 结尾时各块在共享的压缩线程池上并行压缩成独立的 gzip 成员或
+ *  zstd 帧，按提交顺序拼接写出；多成员 / 多帧文件是合法的 gzip / zstd 文件，
+ *  解压结果与不压缩时的文件逐字节相同。
+ *  新建文件先写到 <文件名>.tmp，close() 成功后才改名为目标文件：中途失败、取消或进程被杀
+ *  都不会留下写了一半的输出，原有的同名文件在改名前保持不变。追加模式直接写目标文件末尾。
+ *  写入失败不抛异常，由 submit() / close() 返回 false，调用方按自己的文件类型报错。
+ */
+class OutputFile
+{
+public:
+    OutputFile() = default;
+    /// 未 close() 时丢弃输出：等待在途的块处理完，删除临时文件
+    ~OutputFile();
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    /// 创建（或以追加方式打开）文件，失败返回 false；
+    /// 文件名要求的压缩方式在本构建中不可用时抛出 std::runtime_error
+    bool open(const std::string &filename, bool append = false);
+    bool isOpen() const { return m_fp != nullptr; }
+
+    /// 当前可写入的缓冲，共 kOutputBlockBytes 字节；submit() 后换成另一块
+    char *buffer() { return m_current.data(); }
+
+    /// 把当前缓冲的前 size 字节交给后台压缩、写出；在途的块已满时等待。
+    /// 之前的写入已失败时返回 false
+    bool submit(size_t size);
+
+    /// 等待写完并关闭文件，新建的文件改名为目标文件；任何一步失败返回 false
+    /// 且不留下文件
+    bool close();
+
+private:
+    /// 已提交、尚未写出的一块
+    struct Block {
+        std::vector<char> data;             ///< 原始数据
+        size_t size = 0;
+        std::vector<char> packed;           ///< 压缩后的数据
+        bool ready = false;                 ///< 压缩完成（或无需压缩），可以写出
+        bool failed = false;                ///< 压缩失败
+    };
+
+    void run();
+    void stopWriter();
+    void compress(Block &block);
+
+    std::string m_filename;
+    std::string m_path;                     ///< 实际写入的路径（新建时为临时文件）
+    bool m_append = false;
+    OutputCompression m_compression = OutputCompression::None;
+    size_t m_depth = 1;                     ///< 最多同时在途的块数
+    FILE *m_fp = nullptr;
+    std::vector<char> m_current;            ///< 调用方正在写的缓冲
+
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<std::unique_ptr<Block>> m_queue;     ///< 按提交顺序等待写出的块
+    bool m_failed = false;
+    bool m_discard = false;                 ///< 输出将被丢弃，剩余的块不再写出
+    bool m_stopping = false;
+};
+
+#endif // OUTPUTFILE_H
@@ -1,326 +1,913 @@
 #include <cstdint>
 #include "parsebin.h"
+#include "mappedfile.h"
+#include "csvwriter.h"
+#include "decodekernel.h"
+#include "perfstats.h"
 
 #include <cstdio>
 #include <stdexcept>
 #include <vector>
 #include <algorithm>
-#include <sstream>
-#include <iomanip>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <functional>
+#include <queue>
 
-// Windows 下若要写ANSI编码，可 include <windows.h> 并调用相关转换API
-#ifdef _WIN32
-#include <windows.h>
-#endif
+// 默认布局：跳过0xC0字节头，首块132字节，后续每块128字节(两组)，见 RecordLayout
+static const size_t kLeadingBytes = 4;              // 首块开头丢弃的 uint32
+static const size_t kReadChunkBytes = 64 * 1024;    // fread 回退路径每次约读 64KB
+static const size_t kParallelChunkBytes = 8 << 20;  // 并行解码每段约 8MB
+static const size_t kProgressBytes = 1 << 20;       // 每解码约 1MB 回报一次进度
 
-// 大端转小端
-static inline uint32_t swapBigEndianToHost(uint32_t v)
+// 按大端读取4字节
+static inline uint32_t loadBigEndian32(const unsigned char *p)
 {
-#if defined(_MSC_VER)
-    return _byteswap_ulong(v);  // MSVC
-#elif defined(__GNUC__) || defined(__clang__)
-    return __builtin_bswap32(v); // GCC/Clang
-#else
-    return ((v & 0xFF000000) >> 24) |
-           ((v & 0x00FF0000) >>  8) |
-           ((v & 0x0000FF00) <<  8) |
-           ((v & 0x000000FF) << 24);
-#endif
+    return ((uint32_t)p[0] << 24) |
+           ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] <<  8) |
+           ((uint32_t)p[3]);
 }
 
-static float parseHexAsFloatLittleEndian(const std::string &hex8)
-{
-    if (hex8.size() < 8)
-        throw std::runtime_error("无效的hex字符串(长度不足8)");
+// BCD 字节 -> 十进制值的查找表，每个时间字段一张；半字节大于9或超出字段范围的
+// 字节为 kBcdInvalid。6 个字段查表后按位或一次即可判断整组时间是否合法，不逐项分支
+static const uint8_t kBcdInvalid = 0x80;
+
+struct BcdTable {
+    uint8_t value[256];
 
-    // 将hex转换为uint32_t（高位在左）
-    uint32_t val = 0;
-    for (char c : hex8) {
-        val <<= 4;
-        if      (c >= '0' && c <= '9') val |= (c - '0');
-        else if (c >= 'A' && c <= 'F') val |= (c - 'A' + 10);
-        else if (c >= 'a' && c <= 'f') val |= (c - 'a' + 10);
-        else throw std::runtime_error("无效的hex字符");
+    constexpr BcdTable(int lo, int hi)
+        : value()
+    {
+        for (int b = 0; b < 256; ++b) {
+            int h = b >> 4, l = b & 0x0F, v = h * 10 + l;
+            value[b] = (h <= 9 && l <= 9 && v >= lo && v <= hi) ? (uint8_t)v : kBcdInvalid;
+        }
     }
+};
 
-    // 大端转为本机端(小端)
-    val = swapBigEndianToHost(val);
+static constexpr BcdTable kBcdYear(0, 99);
+static constexpr BcdTable kBcdMonth(1, 12);
+static constexpr BcdTable kBcdDay(1, 31);
+static constexpr BcdTable kBcdHour(0, 23);
+static constexpr BcdTable kBcdMinuteSecond(0, 59);
 
-    float f;
-    std::memcpy(&f, &val, sizeof(float));
-    // 保留两位小数
-    double temp = std::round(f * 100.0) / 100.0;
-    return static_cast<float>(temp);
+// 解析时间字 "YYMMDDhh"、"mmssxxxx"（按半字节的十进制），非法时返回 false
+static inline bool decodeDateTimeWords(uint32_t w1, uint32_t w2, uint64_t &ts)
+{
+    uint32_t YY = kBcdYear.value[w1 >> 24];
+    uint32_t MM = kBcdMonth.value[(w1 >> 16) & 0xFF];
+    uint32_t DD = kBcdDay.value[(w1 >> 8) & 0xFF];
+    uint32_t hh = kBcdHour.value[w1 & 0xFF];
+    uint32_t mm = kBcdMinuteSecond.value[w2 >> 24];
+    uint32_t ss = kBcdMinuteSecond.value[(w2 >> 16) & 0xFF];
+    if ((YY | MM | DD | hh | mm | ss) & kBcdInvalid) {
+        return false;
+    }
+    // 年份处理（假设是2000年之后的年份）
+    ts = packTimestamp(2000 + (int)YY, (int)MM, (int)DD, (int)hh, (int)mm, (int)ss);
+    return true;
 }
 
-// 解析 "YYMMDDhh"、"mmssxxxx"（十进制）
-static Record parseDateTimeFromTwoHex(const std::string &hex1, const std::string &hex2)
+// 整块全为 0x00 或全为 0xFF（未写入或已擦除的闪存页）时其中每组的时间字都非法，
+// 可整块跳过。正常数据块在比较开头8字节时即返回
+static inline bool isBlankBlock(const unsigned char *p, size_t bytes)
 {
-    if (hex1.size() < 8 || hex2.size() < 8) {
-        throw std::runtime_error("时间字段长度不够");
+    if (bytes < 8) {
+        return false;
     }
+    uint64_t first;
+    std::memcpy(&first, p, 8);
+    if (first != 0 && first != ~(uint64_t)0) {
+        return false;
+    }
+    uint64_t diff = 0;
+    size_t i = 8;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        diff |= w ^ first;
+    }
+    for (; i < bytes; ++i) {
+        diff |= (uint8_t)(p[i] ^ (uint8_t)first);
+    }
+    return diff == 0;
+}
 
-    auto decToInt = [&](const std::string &s, int pos) -> int {
-        // 提取两位十进制数
-        char c1 = s[pos];
-        char c2 = s[pos + 1];
-        if (c1 < '0' || c1 > '9' || c2 < '0' || c2 > '9') {
-            throw std::runtime_error("非十进制数字");
-        }
-        return (c1 - '0') * 10 + (c2 - '0');
-    };
-
-    // 提取日期和时间
-    int YY = decToInt(hex1, 0);  // 年
-    int MM = decToInt(hex1, 2);  // 月
-    int DD = decToInt(hex1, 4);  // 日
-    int hh = decToInt(hex1, 6);  // 时
+// 列序号 -> 组内 float 序号（最后两个通道与 python 版一致交换）
+static const size_t kColumnWord[kChannelCount] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 12, 11 };
 
-    int mm = decToInt(hex2, 0);  // 分
-    int ss = decToInt(hex2, 2);  // 秒
+// 解析一组并写入 out，时间非法时跳过该组。各偏移为组内字节偏移，
+// 由专用解码器以编译期常量传入时整段展开为定长访问
+static inline void decodeGroup(const unsigned char *p, size_t time1, size_t time2,
+                               size_t floats, TableSlice &out)
+{
+    uint64_t ts;
+    if (!decodeDateTimeWords(loadBigEndian32(p + time1), loadBigEndian32(p + time2), ts)) {
+        return;
+    }
+    // 13个 float 由向量内核一次解码
+    float values[kChannelCount];
+    decodeFloats(p + floats, values, kChannelCount);
+
+    RecordTable &t = *out.table;
+    t.timestamps[out.pos] = ts;
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        t.columns[c][out.pos] = values[kColumnWord[c]];
+    }
+    ++out.pos;
+}
 
-    // 年份处理（假设是2000年之后的年份）
-    int year = 2000 + YY;
-    if (year < 2000 || year > 2100) throw std::runtime_error("年份超范围");
-    if (MM < 1 || MM > 12)         throw std::runtime_error("月份无效");
-    if (DD < 1 || DD > 31)         throw std::runtime_error("日期无效");
-    if (hh < 0 || hh > 23)         throw std::runtime_error("小时无效");
-    if (mm < 0 || mm > 59)         throw std::runtime_error("分钟无效");
-    if (ss < 0 || ss > 59)         throw std::runtime_error("秒无效");
-
-    // 将提取的日期和时间存储到 Record 结构体中
-    Record r;
-    r.year = year;  r.month = MM;  r.day = DD;
-    r.hour = hh;    r.minute = mm; r.second = ss;
-
-    // 生成日期字符串（如 "2025/01/10"）
+/**
+ * 已知布局的专用解码器：块大小、组长和组内各字位置都是模板参数，
+ * 组循环与偏移计算在编译期确定。
+ */
+template <size_t BlockBytes, size_t GroupWords, bool SkipFirst,
+          size_t Time1, size_t Time2, size_t FloatStart>
+struct FixedLayoutDecoder {
+    static constexpr size_t kGroupBytes = GroupWords * 4;
+    static constexpr size_t kBase = SkipFirst ? 1 : 0;
+
+    static bool matches(const RecordLayout &l)
     {
-        std::ostringstream oss;
-        oss << year << "/" << std::setw(2) << std::setfill('0') << MM << "/"
-            << std::setw(2) << std::setfill('0') << DD;
-        r.dateStr = oss.str();
+        return l.subsequentBlockSize == BlockBytes && l.groupSize == GroupWords &&
+               l.skipFirstGroupItem == SkipFirst && l.timeIndex[0] == Time1 &&
+               l.timeIndex[1] == Time2 && l.floatStartIndex == FloatStart;
     }
 
-    // 生成时间字符串（如 "13:30:45"）
+    static void decode(const RecordLayout &, const unsigned char *p, size_t blockCount,
+                       TableSlice &out)
     {
-        std::ostringstream oss;
-        oss << std::setw(2) << std::setfill('0') << hh << ":"
-            << std::setw(2) << std::setfill('0') << mm << ":"
-            << std::setw(2) << std::setfill('0') << ss;
-        r.timeStr = oss.str();
+        for (size_t b = 0; b < blockCount; ++b, p += BlockBytes) {
+            if (isBlankBlock(p, BlockBytes)) {
+                continue;
+            }
+            for (size_t g = 0; g + kGroupBytes <= BlockBytes; g += kGroupBytes) {
+                decodeGroup(p + g, (kBase + Time1) * 4, (kBase + Time2) * 4,
+                            (kBase + FloatStart) * 4, out);
+            }
+        }
     }
+};
 
-    return r;
+// 通用解码：按布局参数逐组解释，任意块大小
+static void decodeBlocksGeneric(const RecordLayout &l, const unsigned char *p, size_t blockCount,
+                                TableSlice &out, size_t blockBytes)
+{
+    size_t groupBytes = l.groupBytes();
+    size_t time1 = l.wordOffset(l.timeIndex[0]);
+    size_t time2 = l.wordOffset(l.timeIndex[1]);
+    size_t floats = l.wordOffset(l.floatStartIndex);
+    for (size_t b = 0; b < blockCount; ++b, p += blockBytes) {
+        if (isBlankBlock(p, blockBytes)) {
+            continue;
+        }
+        for (size_t g = 0; g + groupBytes <= blockBytes; g += groupBytes) {
+            decodeGroup(p + g, time1, time2, floats, out);
+        }
+    }
 }
 
-std::vector<Record> parseBinFile(const std::string &binFilename)
+static void decodeUniformGeneric(const RecordLayout &l, const unsigned char *p, size_t blockCount,
+                                 TableSlice &out)
 {
-    std::vector<Record> rows;
+    decodeBlocksGeneric(l, p, blockCount, out, l.subsequentBlockSize);
+}
 
-    FILE* fp = std::fopen(binFilename.c_str(), "rb");
-    if (!fp) {
-        throw std::runtime_error("无法打开文件：" + binFilename);
+// 带查询的解码：时间范围外的组丢弃，只解码投影的列。按布局参数逐组解释
+static void decodeBlocksQuery(const RecordLayout &l, const RecordQuery &q, const unsigned char *p,
+                              size_t blockCount, TableSlice &out, size_t blockBytes)
+{
+    size_t groupBytes = l.groupBytes();
+    size_t time1 = l.wordOffset(l.timeIndex[0]);
+    size_t time2 = l.wordOffset(l.timeIndex[1]);
+    size_t floats = l.wordOffset(l.floatStartIndex);
+    // 投影列及其在组内的字节偏移
+    size_t columns[kChannelCount];
+    size_t offsets[kChannelCount];
+    size_t n = 0;
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if ((q.columnMask >> c) & 1) {
+            columns[n] = c;
+            offsets[n] = floats + kColumnWord[c] * 4;
+            ++n;
+        }
     }
-    // 跳过0xC0字节
-    if(std::fseek(fp, 0xC0, SEEK_SET) != 0) {
-        std::fclose(fp);
-        throw std::runtime_error("fseek失败或文件过小：" + binFilename);
+
+    RecordTable &t = *out.table;
+    for (size_t b = 0; b < blockCount; ++b, p += blockBytes) {
+        if (isBlankBlock(p, blockBytes)) {
+            continue;
+        }
+        for (size_t g = 0; g + groupBytes <= blockBytes; g += groupBytes) {
+            const unsigned char *group = p + g;
+            uint64_t ts;
+            if (!decodeDateTimeWords(loadBigEndian32(group + time1),
+                                     loadBigEndian32(group + time2), ts) || !q.contains(ts)) {
+                continue;
+            }
+            t.timestamps[out.pos] = ts;
+            if (n == kChannelCount) {
+                float values[kChannelCount];
+                decodeFloats(group + floats, values, kChannelCount);
+                for (size_t c = 0; c < kChannelCount; ++c) {
+                    t.columns[c][out.pos] = values[kColumnWord[c]];
+                }
+            } else {
+                for (size_t k = 0; k < n; ++k) {
+                    decodeFloats(group + offsets[k], &t.columns[columns[k]][out.pos], 1);
+                }
+            }
+            ++out.pos;
+        }
     }
+}
 
-    bool firstRead = true;
-    while(true) {
-        // 第一次132字节(33个uint32)，后续128字节(32个uint32)
-        size_t blockSize = firstRead ? 132 : 128;
-        std::vector<unsigned char> buffer(blockSize);
+// 当前控制器：128字节块，每组16字，[0]丢弃，[1][2]为时间，[3..15]为13个float
+typedef FixedLayoutDecoder<128, 16, true, 0, 1, 2> ControllerLayoutDecoder;
 
-        size_t readCount = std::fread(buffer.data(), 1, blockSize, fp);
-        if (readCount < blockSize) {
-            // 读不足，结束
-            break;
+// 已知布局表；新控制器的布局在此登记即可获得专用解码
+static const struct {
+    bool (*matches)(const RecordLayout &);
+    void (*decode)(const RecordLayout &, const unsigned char *, size_t, TableSlice &);
+} kFixedDecoders[] = {
+    { &ControllerLayoutDecoder::matches, &ControllerLayoutDecoder::decode },
+};
+
+static inline bool isCancelled(const ParseOptions &options)
+{
+    return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+// 把 table 中 [from, to) 行的时间范围计入块 block 所在的索引项
+static void noteIndexRows(BlockIndex &index, size_t block, const RecordTable &table,
+                          size_t from, size_t to)
+{
+    BlockIndexEntry &e = index.entries[block / index.entryBlocks];
+    for (size_t i = from; i < to; ++i) {
+        e.minTimestamp = std::min(e.minTimestamp, table.timestamps[i]);
+        e.maxTimestamp = std::max(e.maxTimestamp, table.timestamps[i]);
+    }
+}
+
+// 按进度粒度分段解码 blockCount 个块，每段后回报进度并检查取消；被取消返回 false。
+// index 非空时分段不跨索引项，顺带记录各项的时间范围，firstBlock 为 p 在块序列中的序号
+static bool decodeBlocksWithProgress(const BinBlockReader &reader, const unsigned char *p,
+                                     size_t blockCount, TableSlice &out,
+                                     const ParseOptions &options,
+                                     BlockIndex *index = nullptr, size_t firstBlock = 0)
+{
+    if (!options.progress && !options.cancel && !index) {
+        reader.decodeBlocks(p, blockCount, out);
+        return true;
+    }
+    size_t blockSize = reader.blockSize();
+    size_t step = std::max<size_t>(1, kProgressBytes / blockSize);
+    for (size_t done = 0; done < blockCount; ) {
+        if (isCancelled(options)) {
+            return false;
+        }
+        size_t count = std::min(step, blockCount - done);
+        size_t block = firstBlock + done;
+        if (index) {
+            size_t entryBlocks = (size_t)index->entryBlocks;
+            count = std::min(count, entryBlocks - block % entryBlocks);
+        }
+        size_t rowsBefore = out.pos;
+        reader.decodeBlocks(p + done * blockSize, count, out);
+        if (index) {
+            noteIndexRows(*index, block, *out.table, rowsBefore, out.pos);
+        }
+        done += count;
+        if (options.progress) {
+            options.progress(count * blockSize, out.pos - rowsBefore);
         }
+    }
+    return true;
+}
 
-        size_t intCount = firstRead ? 33 : 32;
-        std::vector<uint32_t> values;
-        values.reserve(intCount);
+// 解析整段数据并追加到表中。块大小固定，任意块边界都可独立解码：
+// 大文件按块切分后并行解码，每段写入表中各自的区间，最后按原顺序压紧。
+// index 非空时顺带记录索引，各段按索引项对齐，互不写同一项
+static void decodeSpan(const BinBlockReader &reader, const unsigned char *blocks,
+                       size_t blockCount, RecordTable &table, const ParseOptions &options,
+                       BlockIndex *index = nullptr)
+{
+    size_t base = table.size();
+    size_t rowsPerBlock = reader.rowsPerBlock();
+    size_t blockSize = reader.blockSize();
+    table.resize(base + blockCount * rowsPerBlock);
+
+    ThreadPool *pool = options.pool;
+    size_t chunkBlocks = std::max<size_t>(1, kParallelChunkBytes / blockSize);
+    if (index) {
+        size_t entryBlocks = (size_t)index->entryBlocks;
+        chunkBlocks = (chunkBlocks + entryBlocks - 1) / entryBlocks * entryBlocks;
+    }
+    size_t chunkCount = (blockCount + chunkBlocks - 1) / chunkBlocks;
+    if (!pool || pool->size() < 2 || chunkCount < 2) {
+        TableSlice out{ &table, base };
+        if (!decodeBlocksWithProgress(reader, blocks, blockCount, out, options, index)) {
+            table.resize(base);
+            throw ParseCancelled();
+        }
+        table.resize(out.pos);
+        return;
+    }
 
-        // 每4字节组成一个uint32(大端)
-        for(size_t i=0; i<intCount; ++i){
-            size_t offset = i*4;
-            uint32_t val=0;
-            val |= (uint32_t)buffer[offset+0] <<24;
-            val |= (uint32_t)buffer[offset+1] <<16;
-            val |= (uint32_t)buffer[offset+2] << 8;
-            val |= (uint32_t)buffer[offset+3];
-            values.push_back(val);
+    std::vector<size_t> produced(chunkCount);
+    std::atomic<bool> cancelled(false);
+    pool->parallelFor(chunkCount, [&](size_t k){
+        size_t first = k * chunkBlocks;
+        size_t count = std::min(chunkBlocks, blockCount - first);
+        TableSlice out{ &table, base + first * rowsPerBlock };
+        if (!decodeBlocksWithProgress(reader, blocks + first * blockSize, count, out, options,
+                                      index, first)) {
+            cancelled = true;
         }
+        produced[k] = out.pos - (base + first * rowsPerBlock);
+    });
+    if (cancelled) {
+        table.resize(base);
+        throw ParseCancelled();
+    }
 
-        // 如果是首块，丢弃第0个
-        std::vector<uint32_t> mainVals;
-        if (firstRead) {
-            for(size_t i=1; i<values.size(); ++i){
-                mainVals.push_back(values[i]);
-            }
-            firstRead=false;
+    size_t pos = base + produced[0];
+    for (size_t k = 1; k < chunkCount; ++k) {
+        table.moveRows(base + k * chunkBlocks * rowsPerBlock, produced[k], pos);
+        pos += produced[k];
+    }
+    table.resize(pos);
+}
+
+BinBlockReader::BinBlockReader(const std::string &binFilename, const RecordLayout &layout,
+                               const RecordQuery &query, const BlockIndex *index)
+    : m_layout(layout)
+    , m_query(query)
+{
+    PerfTimer timer(PerfStage::Read);
+    m_layout.validate();
+    m_decode = &decodeUniformGeneric;
+    for (const auto &known : kFixedDecoders) {
+        if (known.matches(m_layout)) {
+            m_decode = known.decode;
+            break;
+        }
+    }
+
+    // 首块去掉开头 uint32 后与后续块等长时并入块序列，否则单独读出
+    size_t headBytes = m_layout.initialBlockSize - kLeadingBytes;
+    bool separateHead = m_layout.separateHead();
+    m_dataOffset = m_layout.dataOffset();
+
+    // 有时间范围而调用方没有给出索引时，使用 bin 旁仍然有效的索引；没有时在映射前取得
+    // 文件状态，扫描建立的索引按此写出，之后文件被改写时随即失效
+    bool stamped = false;
+    if (!index && query.hasTimeRange()) {
+        if (loadBlockIndex(binFilename, m_layout, m_index)) {
+            index = &m_index;
         } else {
-            mainVals = values;
+            stamped = binFileStamp(binFilename, m_index.inputSize, m_index.inputMtime);
         }
+    }
 
-        // 转为8位hex字符串
-        std::vector<std::string> hexVals;
-        hexVals.reserve(mainVals.size());
-        for (auto v : mainVals) {
-            char buf[16];
-            std::snprintf(buf, sizeof(buf), "%08X", v); // 大写HEX
-            hexVals.push_back(std::string(buf));
+    // 普通文件优先内存映射，整段数据线性扫描
+    if (inputKindForPath(binFilename) == InputKind::File && m_mapped.open(binFilename)) {
+        uint64_t size = m_mapped.size();
+        if (separateHead && size >= m_dataOffset) {
+            const unsigned char *head = m_mapped.data() + m_layout.fileOffset + kLeadingBytes;
+            m_head.assign(head, head + headBytes);
+            m_headPending = true;
+        }
+        uint64_t span = size > m_dataOffset ? size - m_dataOffset : 0;
+        m_blockCount = (size_t)(span / blockSize());
+        if (m_blockCount > 0) {
+            m_blocks = m_mapped.data() + m_dataOffset;
+        }
+        narrowToTimeRange(index);
+        if (stamped) {
+            saveScannedIndex(binFilename);
+        }
+        return;
+    }
+
+    // 顺序读取回退路径（管道、网络共享、压缩输入等）
+    m_source = openInputSource(binFilename);
+    // 跳过文件头
+    if (!m_source->skip(m_layout.fileOffset)) {
+        throw std::runtime_error("fseek失败或文件过小：" + binFilename);
+    }
+    // 丢弃首个uint32
+    unsigned char lead[kLeadingBytes];
+    m_eof = m_source->readFully(lead, kLeadingBytes) < kLeadingBytes;
+    if (separateHead && !m_eof) {
+        m_head.resize(headBytes);
+        if (m_source->readFully(m_head.data(), headBytes) < headBytes) {
+            m_eof = true;
+        } else {
+            m_headPending = true;
         }
+    }
+    // 按索引直接跳到范围内的第一个块，读到最后一个为止
+    if (index && m_query.hasTimeRange() && !m_eof) {
+        uint64_t span = index->inputSize > m_dataOffset ? index->inputSize - m_dataOffset : 0;
+        if (index->blockCount == span / blockSize()) {
+            size_t first, last;
+            index->findBlocks(m_query.begin, m_query.end, first, last);
+            seekForward((uint64_t)first * blockSize());
+            m_blockLimit = last - first;
+            m_skippedBytes = (index->blockCount - m_blockLimit) * blockSize();
+        }
+    }
+}
 
-        // 每16个一组, 跳过第1个
-        for(size_t i=0; i+16 <= hexVals.size(); i+=16){
-            std::vector<std::string> group(hexVals.begin()+i, hexVals.begin()+i+16);
+BinBlockReader::~BinBlockReader()
+{
+}
 
-            // group[0]丢弃
-            group.erase(group.begin());
-            // 现在 group.size()==15
-            if(group.size()<2) continue;
+// 解码计数；时间非法的组不产生行，跳过的组数即组数与行数之差
+static inline void countDecoded(uint64_t bytes, uint64_t groups, uint64_t rows)
+{
+    if (perfStatsEnabled()) {
+        perfCount(PerfCounter::InputBytes, bytes);
+        perfCount(PerfCounter::Groups, groups);
+        perfCount(PerfCounter::SkippedGroups, groups - rows);
+    }
+}
 
-            // 解析时间
-            Record rec;
-            try {
-                rec = parseDateTimeFromTwoHex(group[0], group[1]);
-            } catch(...) {
-                // 时间解析出错就跳过
-                continue;
-            }
+void BinBlockReader::narrowToTimeRange(const BlockIndex *index)
+{
+    if (!m_query.hasTimeRange() || m_blockCount == 0) {
+        return;
+    }
+    // 索引记录了每段的精确范围，输入无序时同样可靠
+    if (index && index->blockCount == m_blockCount) {
+        size_t first, last;
+        index->findBlocks(m_query.begin, m_query.end, first, last);
+        selectBlocks(first, last);
+        return;
+    }
+    // 没有索引时逐组读一遍时间字（不解码数值）：抽样无法证明有序，短段的回退（如控制器
+    // 时钟回拨）会丢掉范围内的行。同一遍里按 BlockIndex 的格式记下各段的精确范围，
+    // 写成 bin 旁的索引，之后的查询按索引定位，不必再扫描
+    scanBlockIndex();
+    size_t first, last;
+    m_index.findBlocks(m_query.begin, m_query.end, first, last);
+    selectBlocks(first, last);
+}
 
-            // 剩余13个hex解析float
-            if(group.size() < 15) continue;
-            std::vector<float> fvals;
-            for(size_t idx=2; idx<group.size(); ++idx){
-                float fv = parseHexAsFloatLittleEndian(group[idx]);
-                fvals.push_back(fv);
+// 读一遍全部块（及单独的首块）的时间字，建立与 parseBinFile 写出的相同的索引
+void BinBlockReader::scanBlockIndex()
+{
+    BlockIndex &index = m_index;
+    index.layout = m_layout.toString();
+    index.blockCount = m_blockCount;
+    index.entries.resize((m_blockCount + index.entryBlocks - 1) / index.entryBlocks);
+    size_t blockBytes = blockSize();
+    size_t groupBytes = m_layout.groupBytes();
+    size_t time1 = m_layout.wordOffset(m_layout.timeIndex[0]);
+    size_t time2 = m_layout.wordOffset(m_layout.timeIndex[1]);
+    auto scanGroups = [&](const unsigned char *p, size_t bytes, BlockIndexEntry &e){
+        for (size_t g = 0; g + groupBytes <= bytes; g += groupBytes) {
+            uint64_t ts;
+            if (decodeDateTimeWords(loadBigEndian32(p + g + time1),
+                                    loadBigEndian32(p + g + time2), ts)) {
+                e.minTimestamp = std::min(e.minTimestamp, ts);
+                e.maxTimestamp = std::max(e.maxTimestamp, ts);
             }
+        }
+    };
+    BlockIndexEntry head;
+    scanGroups(m_head.data(), m_head.size(), head);
+    index.minTimestamp = head.minTimestamp;
+    index.maxTimestamp = head.maxTimestamp;
+    for (size_t k = 0; k < index.entries.size(); ++k) {
+        BlockIndexEntry &e = index.entries[k];
+        size_t first = k * (size_t)index.entryBlocks;
+        size_t count = std::min((size_t)index.entryBlocks, m_blockCount - first);
+        e.offset = m_dataOffset + (uint64_t)first * blockBytes;
+        scanGroups(m_blocks + first * blockBytes, count * blockBytes, e);
+        index.minTimestamp = std::min(index.minTimestamp, e.minTimestamp);
+        index.maxTimestamp = std::max(index.maxTimestamp, e.maxTimestamp);
+    }
+}
+
+// 扫描建立了索引时写到 bin 旁
+void BinBlockReader::saveScannedIndex(const std::string &binFilename) const
+{
+    if (m_index.entries.empty()) {
+        return;
+    }
+    try {
+        writeBlockIndex(blockIndexPathFor(binFilename), m_index);
+    } catch (const std::runtime_error &) {
+        // 索引只用于加速，目录只读等原因写不了时照常解析
+    }
+}
+
+// 块序列只保留 [first, end)，并对其恢复顺序预读
+void BinBlockReader::selectBlocks(size_t first, size_t end)
+{
+    size_t blockBytes = blockSize();
+    m_skippedBytes = (uint64_t)(m_blockCount - (end - first)) * blockBytes;
+    m_blocks += first * blockBytes;
+    m_blockCount = end - first;
+    m_mapped.advise((size_t)(m_blocks - m_mapped.data()), m_blockCount * blockBytes, true);
+}
+
+void BinBlockReader::prepareTable(RecordTable &table) const
+{
+    if (table.empty()) {
+        table.columnMask = m_query.columnMask;
+    } else if (table.columnMask != m_query.columnMask) {
+        throw std::runtime_error("记录表保存的列与查询不一致");
+    }
+}
+
+void BinBlockReader::decodeBlocks(const unsigned char *p, size_t blockCount, TableSlice &out) const
+{
+    PerfTimer timer(PerfStage::Decode);
+    size_t before = out.pos;
+    if (m_query.active()) {
+        decodeBlocksQuery(m_layout, m_query, p, blockCount, out, blockSize());
+    } else {
+        m_decode(m_layout, p, blockCount, out);
+    }
+    countDecoded(blockCount * blockSize(), blockCount * rowsPerBlock(), out.pos - before);
+}
+
+size_t BinBlockReader::decodeHead(RecordTable &table)
+{
+    if (!m_headPending) {
+        return 0;
+    }
+    m_headPending = false;
+    prepareTable(table);
+    PerfTimer timer(PerfStage::Decode);
+    size_t base = table.size();
+    size_t groups = m_head.size() / m_layout.groupBytes();
+    table.resize(base + groups);
+    TableSlice out{ &table, base };
+    if (m_query.active()) {
+        decodeBlocksQuery(m_layout, m_query, m_head.data(), 1, out, m_head.size());
+    } else {
+        decodeBlocksGeneric(m_layout, m_head.data(), 1, out, m_head.size());
+    }
+    table.resize(out.pos);
+    countDecoded(m_head.size(), groups, out.pos - base);
+    return out.pos - base;
+}
+
+bool BinBlockReader::mappedBlocks(const unsigned char *&blocks, size_t &blockCount) const
+{
+    if (!m_mapped.isOpen()) {
+        return false;
+    }
+    blocks = m_blocks;
+    blockCount = m_blockCount;
+    return true;
+}
+
+const unsigned char *BinBlockReader::nextBlocks(size_t maxBlocks, size_t &count)
+{
+    count = 0;
+    size_t blockBytes = blockSize();
+    if (m_mapped.isOpen()) {
+        count = std::min(maxBlocks, m_blockCount - m_nextBlock);
+        const unsigned char *p = m_blocks + m_nextBlock * blockBytes;
+        m_nextBlock += count;
+        m_lastBlock = count ? p + (count - 1) * blockBytes : nullptr;
+        return p;
+    }
+
+    // 每次读入多个整块；读不足即结束，不足一块的尾部忽略
+    m_lastBlock = nullptr;
+    maxBlocks = std::min(maxBlocks, m_blockLimit);
+    if (m_eof || maxBlocks == 0) {
+        return nullptr;
+    }
+    PerfTimer timer(PerfStage::Read);
+    m_buffer.resize(maxBlocks * blockBytes);
+    size_t readCount = m_source->readFully(m_buffer.data(), m_buffer.size());
+    if (readCount < m_buffer.size()) {
+        m_eof = true;
+    }
+    count = readCount / blockBytes;
+    m_blockLimit -= count;
+    if (count) {
+        m_lastBlock = m_buffer.data() + (count - 1) * blockBytes;
+    }
+    return m_buffer.data();
+}
+
+void BinBlockReader::skipBlocks(size_t count)
+{
+    m_headPending = false;
+    m_lastBlock = nullptr;
+    if (m_mapped.isOpen()) {
+        m_nextBlock += std::min(count, m_blockCount - m_nextBlock);
+        return;
+    }
+    count = std::min(count, m_blockLimit);
+    m_blockLimit -= count;
+    seekForward((uint64_t)count * blockSize());
+}
+
+void BinBlockReader::seekForward(uint64_t bytes)
+{
+    // 普通文件直接定位，压缩流与管道读出后丢弃
+    if (!m_eof && !m_source->skip(bytes)) {
+        m_eof = true;
+    }
+}
+
+size_t BinBlockReader::decodeNext(RecordTable &table, size_t maxBlocks)
+{
+    prepareTable(table);
+    decodeHead(table);
+    size_t count;
+    const unsigned char *p = nextBlocks(maxBlocks, count);
+    size_t base = table.size();
+    table.resize(base + count * rowsPerBlock());
+    TableSlice out{ &table, base };
+    decodeBlocks(p, count, out);
+    table.resize(out.pos);
+    return count;
+}
+
+// 索引扩到 blockCount 个块，新增的项填好偏移
+static void growIndex(BlockIndex &index, const BinBlockReader &reader, size_t blockCount)
+{
+    size_t entryBlocks = (size_t)index.entryBlocks;
+    size_t k = index.entries.size();
+    index.entries.resize((blockCount + entryBlocks - 1) / entryBlocks);
+    for (; k < index.entries.size(); ++k) {
+        index.entries[k].offset = reader.dataOffset() + (uint64_t)k * entryBlocks * reader.blockSize();
+    }
+    index.blockCount = blockCount;
+}
+
+// 汇总全文件的时间范围（含单独首块解析出的 [headBegin, headEnd) 行）并写出索引
+static void finishIndex(BlockIndex &index, const RecordTable &table, size_t headBegin,
+                        size_t headEnd, const std::string &binFilename)
+{
+    for (size_t i = headBegin; i < headEnd; ++i) {
+        index.minTimestamp = std::min(index.minTimestamp, table.timestamps[i]);
+        index.maxTimestamp = std::max(index.maxTimestamp, table.timestamps[i]);
+    }
+    for (const BlockIndexEntry &e : index.entries) {
+        index.minTimestamp = std::min(index.minTimestamp, e.minTimestamp);
+        index.maxTimestamp = std::max(index.maxTimestamp, e.maxTimestamp);
+    }
+    try {
+        writeBlockIndex(blockIndexPathFor(binFilename), index);
+    } catch (const std::runtime_error &) {
+        // 索引只用于加速，目录只读等原因写不了时照常返回解析结果
+    }
+}
+
+void parseBinFile(const std::string &binFilename, RecordTable &table, const ParseOptions &options)
+{
+    if (isCancelled(options)) {
+        throw ParseCancelled();
+    }
+    RecordLayout layout = options.layout ? *options.layout : RecordLayout();
+    RecordQuery query = options.query ? *options.query : RecordQuery();
+
+    // 有效索引用于定位时间范围；没有时，整文件解析顺带建立。
+    // 文件状态在打开前取得，解析期间文件被改写时索引随即失效
+    BlockIndex index;
+    bool haveIndex = false;
+    bool buildIndex = false;
+    if (options.blockIndex) {
+        haveIndex = loadBlockIndex(binFilename, layout, index);
+        buildIndex = !haveIndex && !query.hasTimeRange() &&
+                     binFileStamp(binFilename, index.inputSize, index.inputMtime);
+    }
+    BlockIndex *building = nullptr;
+    if (buildIndex) {
+        index.layout = layout.toString();
+        building = &index;
+    }
 
-            rec.floatValues = fvals;
-            rows.push_back(rec);
+    BinBlockReader reader(binFilename, layout, query, haveIndex ? &index : nullptr);
+    // 文件头与时间范围外未读取的块计入进度
+    if (options.progress) {
+        options.progress(reader.dataOffset() + reader.skippedBytes(), 0);
+    }
+
+    reader.prepareTable(table);
+    size_t start = table.size();
+    reader.decodeHead(table);
+    size_t headEnd = table.size();
+
+    const unsigned char *blocks;
+    size_t blockCount;
+    if (reader.mappedBlocks(blocks, blockCount)) {
+        if (building) {
+            growIndex(index, reader, blockCount);
+        }
+        try {
+            decodeSpan(reader, blocks, blockCount, table, options, building);
+        } catch (const ParseCancelled &) {
+            table.resize(start);
+            throw;
         }
+        if (building) {
+            finishIndex(index, table, start, headEnd, binFilename);
+        }
+        return;
     }
 
-    std::fclose(fp);
+    size_t chunkBlocks = std::max<size_t>(1, kReadChunkBytes / reader.blockSize());
+    size_t blocksRead = 0;
+    while (true) {
+        size_t count;
+        const unsigned char *p = reader.nextBlocks(chunkBlocks, count);
+        if (count == 0) {
+            break;
+        }
+        if (building) {
+            growIndex(index, reader, blocksRead + count);
+        }
+        size_t base = table.size();
+        table.resize(base + count * reader.rowsPerBlock());
+        TableSlice out{ &table, base };
+        if (!decodeBlocksWithProgress(reader, p, count, out, options, building, blocksRead)) {
+            table.resize(start);
+            throw ParseCancelled();
+        }
+        table.resize(out.pos);
+        blocksRead += count;
+    }
+    if (building) {
+        finishIndex(index, table, start, headEnd, binFilename);
+    }
+}
+
+void parseBinFile(const std::string &binFilename, RecordTable &table)
+{
+    parseBinFile(binFilename, table, ParseOptions());
+}
+
+std::vector<Record> parseBinFile(const std::string &binFilename)
+{
+    RecordTable table;
+    parseBinFile(binFilename, table);
+
+    std::vector<Record> rows(table.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        Record &r = rows[i];
+        uint64_t ts = table.timestamps[i];
+        r.year = timestampYear(ts);  r.month = timestampMonth(ts);   r.day = timestampDay(ts);
+        r.hour = timestampHour(ts);  r.minute = timestampMinute(ts); r.second = timestampSecond(ts);
+
+        char buf[16];
+        formatDate(ts, buf);
+        r.dateStr = buf;
+        formatTime(ts, buf);
+        r.timeStr = buf;
+
+        // 还原为原始通道顺序
+        r.floatValues.resize(kChannelCount);
+        for (size_t c = 0; c < kChannelCount; ++c) {
+            r.floatValues[kColumnWord[c]] = table.columns[c][i];
+        }
+    }
     return rows;
 }
 
-void writeCsv(const std::string &csvFilename, const std::vector<Record> &rowsIn)
+// 按时间戳升序、同一时间戳只保留先出现的一条，依次对每行调用 writeRow(行号)。
+// 控制器数据几乎总是已按时间排列，此时直接顺序扫描；否则仅对行号做稳定排序，记录本身不复制。
+template <typename RowWriter>
+static void forEachUniqueRow(const uint64_t *keys, size_t count, RowWriter &&writeRow)
+{
+    std::vector<uint32_t> order;
+    bool sorted = !sortRowOrder(keys, count, order);
+
+    for (size_t k = 0; k < count; ++k) {
+        size_t i = sorted ? k : order[k];
+        if (k > 0 && keys[i] == keys[sorted ? k - 1 : order[k - 1]]) {
+            continue;
+        }
+        writeRow(i);
+    }
+}
+
+// 写出表中第 i 行（表中保存的各列）
+static inline void writeTableRow(RecordSink &sink, const RecordTable &table, size_t i)
 {
-    // 复制一份并排序
-    std::vector<Record> rows = rowsIn;
-    std::sort(rows.begin(), rows.end(), [](const Record &a, const Record &b){
-        if(a.year != b.year) return a.year < b.year;
-        if(a.month!= b.month) return a.month< b.month;
-        if(a.day  != b.day)   return a.day  < b.day;
-        if(a.hour != b.hour)  return a.hour < b.hour;
-        if(a.minute != b.minute) return a.minute<b.minute;
-        return a.second < b.second;
+    float values[kChannelCount];
+    size_t count = table.gatherRow(i, values);
+    sink.writeRow(table.timestamps[i], values, count);
+}
+
+void writeRecords(RecordSink &sink, const RecordTable &table)
+{
+    PerfTimer timer(PerfStage::Format);
+    sink.writeHeader();
+
+    const std::vector<uint64_t> &ts = table.timestamps;
+    forEachUniqueRow(ts.data(), ts.size(), [&](size_t i){
+        writeTableRow(sink, table, i);
     });
+}
 
-    // 去重（同一时间戳只保留第一条）
-    std::vector<Record> uniqueRows;
-    uniqueRows.reserve(rows.size());
-    Record* last=nullptr;
-    for(auto &r : rows){
-        if(!last ||
-            r.year!=last->year || r.month!=last->month || r.day!=last->day ||
-            r.hour!=last->hour || r.minute!=last->minute || r.second!=last->second)
-        {
-            uniqueRows.push_back(r);
-            last = &uniqueRows.back();
-        }
-    }
-
-// 写CSV (Windows下示例ANSI写法，其他平台默认UTF-8)
-#ifdef _WIN32
-    FILE* fp = std::fopen(csvFilename.c_str(), "wb");
-    if(!fp){
-        throw std::runtime_error("无法创建CSV文件：" + csvFilename);
-    }
-    // 简易函数：字符串(UTF-8)&rarr;本地ACP(ANSI) 写入
-    auto writeLine = [&](const std::string &text){
-        // 将 text(UTF-8) 转为 宽字符
-        int wlen = MultiByteToWideChar(CP_UTF8,0,text.c_str(),-1,NULL,0);
-        if(wlen <=1) return;
-        std::wstring wbuf;
-        wbuf.resize(wlen);
-        MultiByteToWideChar(CP_UTF8,0,text.c_str(),-1,&wbuf[0],wlen);
-
-        // 宽字符 转 ANSI
-        int alen = WideCharToMultiByte(CP_ACP,0,wbuf.c_str(),-1,NULL,0,NULL,NULL);
-        if(alen <=1) return;
-        std::string abuf;
-        abuf.resize(alen-1);
-        WideCharToMultiByte(CP_ACP,0,wbuf.c_str(),-1,&abuf[0],alen-1,NULL,NULL);
-
-        std::fwrite(abuf.data(),1,abuf.size(),fp);
+void writeRecords(RecordSink &sink, const std::vector<RecordTable> &tables)
+{
+    PerfTimer timer(PerfStage::Format);
+    // 每张表各自按时间排序（通常已有序，不产生序号数组）
+    struct Cursor {
+        const RecordTable *table;
+        std::vector<uint32_t> order;
+        bool sorted;
+        size_t pos;
+        size_t row() const { return sorted ? pos : order[pos]; }
+        uint64_t key() const { return table->timestamps[row()]; }
     };
+    std::vector<Cursor> cursors(tables.size());
+    for (size_t t = 0; t < tables.size(); ++t) {
+        Cursor &c = cursors[t];
+        c.table = &tables[t];
+        c.sorted = !sortRowOrder(c.table->timestamps.data(), c.table->size(), c.order);
+        c.pos = 0;
+    }
 
-    // 表头
-    writeLine("日期,时间,"
-              "压力设定/mbar,实际压力/mbar,"
-              "设定温度/℃,实际温度/℃,"
-              "设定功率/KW,实际功率/KW,"
-              "加热电阻/mΩ,加热电压/V,"
-              "加热电流/A,毫托计/Pa,"
-              "氩气流量/SLM,温升/℃/min,"
-              "氟利昂流量/SLM\n");
+    // 小顶堆按 (时间戳, 表序号) 归并：时间戳相同时先输入的表优先，
+    // 结果与拼接后稳定排序一致
+    typedef std::pair<uint64_t, size_t> HeapItem;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+    for (size_t t = 0; t < cursors.size(); ++t) {
+        if (cursors[t].table->size() > 0) {
+            heap.push(HeapItem(cursors[t].key(), t));
+        }
+    }
 
-    // 写每条记录
-    for(auto &r : uniqueRows){
-        // 交换 floatValues[-2] 与 [-1]  (与 python 版保持一致)
-        if(r.floatValues.size() == 13){
-            std::swap(r.floatValues[11], r.floatValues[12]);
+    sink.writeHeader();
+
+    bool first = true;
+    uint64_t last = 0;
+    while (!heap.empty()) {
+        HeapItem top = heap.top();
+        heap.pop();
+        Cursor &c = cursors[top.second];
+        if (first || top.first != last) {
+            writeTableRow(sink, *c.table, c.row());
+            first = false;
+            last = top.first;
         }
-        std::ostringstream oss;
-        oss << r.dateStr << "," << r.timeStr << ",";
-        for(size_t i=0; i<r.floatValues.size(); ++i){
-            oss << r.floatValues[i];
-            if(i+1<r.floatValues.size()) oss << ",";
+        if (++c.pos < c.table->size()) {
+            heap.push(HeapItem(c.key(), top.second));
         }
-        oss << "\n";
-        writeLine(oss.str());
     }
+}
+
+void writeCsv(const std::string &csvFilename, const RecordTable &table, CsvEncoding encoding)
+{
+    CsvWriter writer(csvFilename, encoding, false, table.columnMask);
+    writeRecords(writer, table);
+    writer.close();
+}
 
-    std::fclose(fp);
+void writeCsv(const std::string &csvFilename, const std::vector<RecordTable> &tables,
+              CsvEncoding encoding)
+{
+    CsvWriter writer(csvFilename, encoding, false,
+                     tables.empty() ? kAllColumns : tables.front().columnMask);
+    writeRecords(writer, tables);
+    writer.close();
+}
 
-#else
-    // 非Windows，简单用UTF-8文本输出
-    FILE* fp = std::fopen(csvFilename.c_str(), "w");
-    if(!fp){
-        throw std::runtime_error("无法创建CSV文件：" + csvFilename);
+void writeCsv(const std::string &csvFilename, const std::vector<Record> &rows,
+              CsvEncoding encoding)
+{
+    // 只生成打包时间戳数组用于排序去重，记录本身不复制
+    std::vector<uint64_t> keys(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Record &r = rows[i];
+        keys[i] = packTimestamp(r.year, r.month, r.day, r.hour, r.minute, r.second);
     }
+
+    CsvWriter writer(csvFilename, encoding);
     // 表头
-    std::fprintf(fp, "%s", "日期,时间,"
-                           "压力设定/mbar,实际压力/mbar,"
-                           "设定温度/℃,实际温度/℃,"
-                           "设定功率/KW,实际功率/KW,"
-                           "加热电阻/mΩ,加热电压/V,"
-                           "加热电流/A,毫托计/Pa,"
-                           "氩气流量/SLM,温升/℃/min,"
-                           "氟利昂流量/SLM\n");
-
-    // 数据
-    for(auto &r : uniqueRows){
-        if(r.floatValues.size() == 13){
-            std::swap(r.floatValues[11], r.floatValues[12]);
-        }
-        std::ostringstream oss;
-        oss << r.dateStr << "," << r.timeStr << ",";
-        for(size_t i=0; i<r.floatValues.size(); ++i){
-            oss << r.floatValues[i];
-            if(i+1<r.floatValues.size()) oss << ",";
-        }
-        oss << "\n";
-        std::fprintf(fp, "%s", oss.str().c_str());
-    }
-    std::fclose(fp);
-#endif
+    writer.writeHeader();
+
+    // 写每条记录
+    forEachUniqueRow(keys.data(), keys.size(), [&](size_t i){
+        const Record &r = rows[i];
+        const std::vector<float> &v = r.floatValues;
+        if (v.size() == kChannelCount) {
+            // 交换 floatValues[-2] 与 [-1]  (与 python 版保持一致)
+            float values[kChannelCount];
+            for (size_t c = 0; c < kChannelCount; ++c) {
+                values[c] = v[kColumnWord[c]];
+            }
+            writer.writeRow(r.dateStr, r.timeStr, values, kChannelCount);
+        } else {
+            writer.writeRow(r.dateStr, r.timeStr, v.data(), v.size());
+        }
+    });
+
+    writer.close();
 }
@@ -1,9 +1,25 @@
 #ifndef PARSEBIN_H
 #define PARSEBIN_H
 
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "recordtable.h"
+#include "recordlayout.h"
+#include "recordquery.h"
+#include "blockindex.h"
+#include "mappedfile.h"
+#include "inputsource.h"
+#include "csvwriter.h"
+#include "recordsink.h"
+#include "threadpool.h"
+
 /// 一条解析结果记录
 struct Record {
     int year;
@@ -24,11 +40,180 @@ struct Record {
  */
 std::vector<Record> parseBinFile(const std::string &binFilename);
 
+/**
+ * @brief parseBinFile
+ *  解析给定bin文件，结果追加到列式记录表 table 中（多文件合并时可重复调用）。
+ *  若文件异常或解析错误，可能抛出 std::runtime_error。
+ */
+void parseBinFile(const std::string &binFilename, RecordTable &table);
+
+/// 解析选项
+struct ParseOptions {
+    /// 非空时，内存映射的大文件按块边界切分后在该线程池上并行解码，记录顺序不变
+    ThreadPool *pool = nullptr;
+    /// 进度回调：参数为新消耗的输入字节数与新解析出的行数，约每 1MB 调用一次。
+    /// 并行解码时会在多个线程中并发调用
+    std::function<void(uint64_t bytes, uint64_t rows)> progress;
+    /// 取消标志：置为 true 后解码尽快停止并抛出 ParseCancelled
+    const std::atomic<bool> *cancel = nullptr;
+    /// 记录布局，空为默认布局
+    const RecordLayout *layout = nullptr;
+    /// 时间范围与列投影，空为全部行、全部列
+    const RecordQuery *query = nullptr;
+    /// 没有有效的块时间索引（见 BlockIndex）且不带时间范围时，解析整个文件的同时建立索引。
+    /// 带时间范围时总按索引定位，不受此项影响（见 BinBlockReader）
+    bool blockIndex = false;
+};
+
+/// 解析被 ParseOptions::cancel 取消
+class ParseCancelled : public std::runtime_error
+{
+public:
+    ParseCancelled() : std::runtime_error("已取消") {}
+};
+
+/**
+ * @brief parseBinFile
+ *  同上，按 options 解析。被取消时 table 保持调用前的内容，抛出 ParseCancelled。
+ *  有查询时 table 只保存查询的列；table 非空且保存的列与查询不同时抛出 std::runtime_error。
+ */
+void parseBinFile(const std::string &binFilename, RecordTable &table, const ParseOptions &options);
+
+/// 表中从 pos 开始的一段输出区域，调用方预先把表扩到足够大
+struct TableSlice {
+    RecordTable *table;
+    size_t pos;
+};
+
+/**
+ * @brief BinBlockReader
+ *  按记录布局顺序读取 bin 文件的等长数据块，优先整体内存映射，不可映射时回退到顺序读取。
+ *  供流式处理逐批解析。
+ *  路径为 .gz / .zst、zip 项（<压缩包.zip>!<项名>）或 "-"（标准输入）时经 InputSource
+ *  边解压边读，不解压到临时文件。
+ *  首块去掉开头的 uint32 后与后续块等长时（默认布局即如此），首块直接并入块序列；
+ *  否则首块单独解析（decodeHead），块序列从首块之后开始。
+ *  默认布局走编译期展开的专用解码，其他布局走按参数解释的通用解码，结果相同。
+ *  有查询时只解码查询的列，范围外的行丢弃。有时间范围时按块索引定位：调用方给出的、
+ *  或 bin 旁仍然有效的索引（见 loadBlockIndex），输入无序或走 fread 时同样有效。
+ *  都没有时内存映射的文件在打开时逐组读一遍时间字，同时建立索引并写到 bin 旁，
+ *  之后的查询只读相关的块；块序列只含范围内的块。fread 路径没有索引时逐行过滤。
+ *  打开失败或布局不合法时抛出 std::runtime_error。
+ */
+class BinBlockReader
+{
+public:
+    explicit BinBlockReader(const std::string &binFilename,
+                            const RecordLayout &layout = RecordLayout(),
+                            const RecordQuery &query = RecordQuery(),
+                            const BlockIndex *index = nullptr);
+    ~BinBlockReader();
+
+    BinBlockReader(const BinBlockReader &) = delete;
+    BinBlockReader &operator=(const BinBlockReader &) = delete;
+
+    /// 输入已整体内存映射时返回 true，并给出全部数据块的起始地址与块数
+    bool mappedBlocks(const unsigned char *&blocks, size_t &blockCount) const;
+
+    /// 取接下来最多 maxBlocks 个原始块，count 为实际块数（0 表示已读完）；
+    /// 返回的指针在下一次调用前有效
+    const unsigned char *nextBlocks(size_t maxBlocks, size_t &count);
+
+    /// 解析接下来最多 maxBlocks 个块追加到 table（尚未解析的单独首块一并解析），
+    /// 返回消耗的块数，0 表示已读完
+    size_t decodeNext(RecordTable &table, size_t maxBlocks);
+
+    /// 解析单独的首块并追加到 table，返回行数；首块已并入块序列或已处理过时返回0
+    size_t decodeHead(RecordTable &table);
+
+    /// 解析 p 处连续 blockCount 个块，out 至少要有 blockCount * rowsPerBlock() 行空间，
+    /// 且保存的列与 columnMask() 相同
+    void decodeBlocks(const unsigned char *p, size_t blockCount, TableSlice &out) const;
+
+    /// 解析出的表保存的列
+    uint32_t columnMask() const { return m_query.columnMask; }
+    /// 按时间范围定位后不再读取的块字节数（可直接计入进度）
+    uint64_t skippedBytes() const { return m_skippedBytes; }
+
+    /// 块序列第一个块在文件中的偏移
+    uint64_t dataOffset() const { return m_dataOffset; }
+    /// 块大小
+    size_t blockSize() const { return m_layout.subsequentBlockSize; }
+    /// 每块最多解析出的行数
+    size_t rowsPerBlock() const { return m_layout.subsequentBlockSize / m_layout.groupBytes(); }
+
+    /// 跳过接下来的 count 个块（不足时跳到末尾），单独的首块同时视为已处理
+    void skipBlocks(size_t count);
+
+    /// 空表按查询设定保存的列；非空且不一致时抛出 std::runtime_error
+    void prepareTable(RecordTable &table) const;
+
+    /// 最近一次 nextBlocks / decodeNext 取到的最后一个块，没有时返回 nullptr；
+    /// 在下一次读取前有效
+    const unsigned char *lastBlock() const { return m_lastBlock; }
+
+private:
+    typedef void (*DecodeFn)(const RecordLayout &layout, const unsigned char *p,
+                             size_t blockCount, TableSlice &out);
+
+    void narrowToTimeRange(const BlockIndex *index);
+    void scanBlockIndex();
+    void saveScannedIndex(const std::string &binFilename) const;
+    void selectBlocks(size_t first, size_t end);
+    void seekForward(uint64_t bytes);
+
+    RecordLayout m_layout;
+    RecordQuery m_query;
+    uint64_t m_skippedBytes = 0;
+    BlockIndex m_index;                 ///< 读取器自行读取或扫描时间字建立的索引
+    DecodeFn m_decode = nullptr;
+    uint64_t m_dataOffset = 0;
+    std::vector<unsigned char> m_head;  ///< 单独的首块（去掉开头 uint32），并入块序列时为空
+    bool m_headPending = false;
+
+    MappedFile m_mapped;
+    const unsigned char *m_blocks = nullptr;
+    size_t m_blockCount = 0;
+    size_t m_nextBlock = 0;
+
+    std::unique_ptr<InputSource> m_source;  ///< 未内存映射时的输入流
+    std::vector<unsigned char> m_buffer;
+    bool m_eof = false;
+    size_t m_blockLimit = SIZE_MAX;     ///< fread 路径还可读的块数（按索引定位后）
+    const unsigned char *m_lastBlock = nullptr;
+};
+
 /**
  * @brief writeCsv
  *  将记录列表按(年,月,日,时,分,秒)排序并去重，然后写入到csv文件
+ *  排序只作用于行序号，输入已按时间排列时直接顺序写出；同一时间戳保留先出现的一条。
+ *  encoding 默认 Windows 下写本地ANSI，其他平台写UTF-8。
  *  若写入失败或其他异常，可能抛出 std::runtime_error。
  */
-void writeCsv(const std::string &csvFilename, const std::vector<Record> &rows);
+void writeCsv(const std::string &csvFilename, const std::vector<Record> &rows,
+              CsvEncoding encoding = CsvEncoding::Native);
+
+/**
+ * @brief writeCsv
+ *  同上，输入为列式记录表。时间戳相同的行只保留先出现的一条。
+ */
+void writeCsv(const std::string &csvFilename, const RecordTable &table,
+              CsvEncoding encoding = CsvEncoding::Native);
+
+/**
+ * @brief writeCsv
+ *  同上，输入为多张各自解析的表（如每个bin文件一张），按时间 k 路归并后写出，
+ *  不拼接、不整体排序。结果与按输入顺序拼接后调用单表版本相同。
+ */
+void writeCsv(const std::string &csvFilename, const std::vector<RecordTable> &tables,
+              CsvEncoding encoding = CsvEncoding::Native);
+
+/**
+ * @brief writeRecords
+ *  与对应的 writeCsv 相同的排序去重规则，写入任意输出端（CSV、Arrow 等）。
+ *  会调用 sink.writeHeader()，但不关闭 sink。
+ */
+void writeRecords(RecordSink &sink, const RecordTable &table);
+void writeRecords(RecordSink &sink, const std::vector<RecordTable> &tables);
 
 #endif // PARSEBIN_H
@@ -0,0 +1,235 @@
+#include "perfstats.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+typedef std::chrono::steady_clock PerfClock;
+
+static const size_t kStageCount = (size_t)PerfStage::Count;
+static const size_t kCounterCount = (size_t)PerfCounter::Count;
+static const size_t kMaxTraceEvents = 1 << 20;
+
+std::atomic<bool> g_perfEnabled(false);
+
+static std::atomic<uint64_t> g_stageNanos[kStageCount];
+static std::atomic<uint64_t> g_stageCalls[kStageCount];
+static std::atomic<uint64_t> g_counters[kCounterCount];
+static std::atomic<bool> g_traceEnabled(false);
+static std::atomic<uint64_t> g_droppedEvents(0);
+static std::atomic<uint32_t> g_nextThreadId(0);
+
+struct TraceEvent {
+    PerfStage stage;
+    uint32_t thread;
+    int64_t startNanos;     ///< 相对 g_traceEpoch
+    uint64_t durationNanos;
+};
+
+static std::mutex g_traceMutex;
+static std::vector<TraceEvent> g_traceEvents;
+static PerfClock::time_point g_traceEpoch = PerfClock::now();
+
+// 当前线程最内层的计时，用于扣除嵌套阶段的时间
+static thread_local PerfTimer *t_currentTimer = nullptr;
+static thread_local uint32_t t_threadId = 0;
+
+static uint32_t currentThreadId()
+{
+    if (t_threadId == 0) {
+        t_threadId = ++g_nextThreadId;
+    }
+    return t_threadId;
+}
+
+void setPerfStatsEnabled(bool enabled, bool trace)
+{
+    g_traceEnabled.store(enabled && trace);
+    g_perfEnabled.store(enabled);
+}
+
+void resetPerfStats()
+{
+    for (size_t i = 0; i < kStageCount; ++i) {
+        g_stageNanos[i] = 0;
+        g_stageCalls[i] = 0;
+    }
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        g_counters[i] = 0;
+    }
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    g_traceEvents.clear();
+    g_droppedEvents = 0;
+    g_traceEpoch = PerfClock::now();
+}
+
+void perfCountSlow(PerfCounter counter, uint64_t value)
+{
+    g_counters[(size_t)counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+void PerfTimer::begin(PerfStage stage)
+{
+    m_stage = stage;
+    m_parent = t_currentTimer;
+    t_currentTimer = this;
+    m_start = PerfClock::now();
+}
+
+void PerfTimer::end()
+{
+    PerfClock::time_point now = PerfClock::now();
+    uint64_t total = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count();
+    uint64_t self = total > m_childNanos ? total - m_childNanos : 0;
+    g_stageNanos[(size_t)m_stage].fetch_add(self, std::memory_order_relaxed);
+    g_stageCalls[(size_t)m_stage].fetch_add(1, std::memory_order_relaxed);
+    if (m_parent) {
+        m_parent->m_childNanos += total;
+    }
+    t_currentTimer = m_parent;
+
+    if (g_traceEnabled.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(g_traceMutex);
+        if (g_traceEvents.size() < kMaxTraceEvents) {
+            int64_t start = std::chrono::duration_cast<std::chrono::nanoseconds>(m_start - g_traceEpoch).count();
+            g_traceEvents.push_back(TraceEvent{ m_stage, currentThreadId(), start, total });
+        } else {
+            ++g_droppedEvents;
+        }
+    }
+}
+
+PerfSnapshot perfSnapshot()
+{
+    PerfSnapshot s;
+    for (size_t i = 0; i < kStageCount; ++i) {
+        s.stageNanos[i] = g_stageNanos[i].load();
+        s.stageCalls[i] = g_stageCalls[i].load();
+    }
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        s.counters[i] = g_counters[i].load();
+    }
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    s.traceEvents = g_traceEvents.size();
+    s.droppedEvents = g_droppedEvents.load();
+    return s;
+}
+
+const char *perfStageName(PerfStage stage)
+{
+    static const char *const kNames[kStageCount] = {
+        "read", "decode", "sort_dedup", "format", "compress", "write"
+    };
+    return (size_t)stage < kStageCount ? kNames[(size_t)stage] : "unknown";
+}
+
+const char *perfCounterName(PerfCounter counter)
+{
+    static const char *const kNames[kCounterCount] = {
+        "input_bytes", "groups", "skipped_groups", "rows_written", "output_bytes"
+    };
+    return (size_t)counter < kCounterCount ? kNames[(size_t)counter] : "unknown";
+}
+
+std::string formatPerfSummary(const PerfSnapshot &s, double wallSeconds)
+{
+    // 按显示宽度补齐（汉字占两列）
+    static const char *const kLabels[kStageCount] = {
+        "读取      ", "解码      ", "排序去重  ", "格式化    ", "压缩      ", "写出      "
+    };
+    uint64_t totalNanos = 0;
+    for (size_t i = 0; i < kStageCount; ++i) {
+        totalNanos += s.stageNanos[i];
+    }
+
+    std::string out = "各阶段耗时（各线程相加）:\n";
+    char line[160];
+    for (size_t i = 0; i < kStageCount; ++i) {
+        double seconds = (double)s.stageNanos[i] / 1e9;
+        double share = totalNanos ? 100.0 * (double)s.stageNanos[i] / (double)totalNanos : 0.0;
+        std::snprintf(line, sizeof(line), "  %s %9.3f 秒 %5.1f%%  %" PRIu64 " 次\n",
+                      kLabels[i], seconds, share, s.stageCalls[i]);
+        out += line;
+    }
+
+    const uint64_t *c = s.counters;
+    uint64_t groups = c[(size_t)PerfCounter::Groups];
+    uint64_t skipped = c[(size_t)PerfCounter::SkippedGroups];
+    std::snprintf(line, sizeof(line),
+                  "输入 %.1f MB，%" PRIu64 " 组，跳过非法时间 %" PRIu64 " 组（%.2f%%）\n",
+                  (double)c[(size_t)PerfCounter::InputBytes] / (1 << 20), groups, skipped,
+                  groups ? 100.0 * (double)skipped / (double)groups : 0.0);
+    out += line;
+    std::snprintf(line, sizeof(line), "写出 %" PRIu64 " 行，%.1f MB\n",
+                  c[(size_t)PerfCounter::RowsWritten],
+                  (double)c[(size_t)PerfCounter::OutputBytes] / (1 << 20));
+    out += line;
+    if (wallSeconds > 0.0) {
+        std::snprintf(line, sizeof(line), "墙钟 %.3f 秒，输入吞吐 %.1f MB/s\n", wallSeconds,
+                      (double)c[(size_t)PerfCounter::InputBytes] / (1 << 20) / wallSeconds);
+        out += line;
+    }
+    if (s.droppedEvents) {
+        std::snprintf(line, sizeof(line), "trace 已满，%" PRIu64 " 个区间未记录\n", s.droppedEvents);
+        out += line;
+    }
+    return out;
+}
+
+static FILE *openForWrite(const std::string &path)
+{
+    FILE *fp = std::fopen(path.c_str(), "w");
+    if (!fp) {
+        throw std::runtime_error("无法创建文件：" + path);
+    }
+    return fp;
+}
+
+static void closeWritten(FILE *fp, const std::string &path)
+{
+    bool failed = std::ferror(fp) != 0;
+    if (std::fclose(fp) != 0 || failed) {
+        throw std::runtime_error("写文件失败：" + path);
+    }
+}
+
+void writePerfJson(const std::string &path, const PerfSnapshot &s, double wallSeconds)
+{
+    FILE *fp = openForWrite(path);
+    std::fprintf(fp, "{\n  \"wall_seconds\": %.6f,\n  \"stages\": {\n", wallSeconds);
+    for (size_t i = 0; i < kStageCount; ++i) {
+        std::fprintf(fp, "    \"%s\": { \"seconds\": %.6f, \"calls\": %" PRIu64 " }%s\n",
+                     perfStageName((PerfStage)i), (double)s.stageNanos[i] / 1e9, s.stageCalls[i],
+                     i + 1 < kStageCount ? "," : "");
+    }
+    std::fputs("  },\n  \"counters\": {\n", fp);
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        std::fprintf(fp, "    \"%s\": %" PRIu64 "%s\n", perfCounterName((PerfCounter)i),
+                     s.counters[i], i + 1 < kCounterCount ? "," : "");
+    }
+    std::fputs("  }\n}\n", fp);
+    closeWritten(fp, path);
+}
+
+void writeChromeTrace(const std::string &path)
+{
+    std::vector<TraceEvent> events;
+    {
+        std::lock_guard<std::mutex> lock(g_traceMutex);
+        events = g_traceEvents;
+    }
+    FILE *fp = openForWrite(path);
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", fp);
+    for (size_t i = 0; i < events.size(); ++i) {
+        const TraceEvent &e = events[i];
+        std::fprintf(fp,
+                     "{\"name\":\"%s\",\"cat\":\"bint\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                     "\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                     perfStageName(e.stage), e.thread, (double)e.startNanos / 1e3,
+                     (double)e.durationNanos / 1e3, i + 1 < events.size() ? "," : "");
+    }
+    std::fputs("]}\n", fp);
+    closeWritten(fp, path);
+}
@@ -0,0 +1,121 @@
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * 转换热路径的可选计时与计数。
+ * 默认关闭，此时每个计时点只有一次 relaxed 原子读；计时点都放在块批次、
+ * 缓冲区刷新等粗粒度位置，不在逐行循环里。
+ * 阶段计时按线程嵌套：外层阶段只计自身（不含内层阶段）的时间，
+ * 各阶段相加即各线程忙碌时间之和。
+ */
+
+/// 计时阶段
+enum class PerfStage {
+    Read,       ///< 从文件读入（内存映射时为建立映射，页面换入计入 Decode）
+    Decode,     ///< 解码数据块，含时间字校验
+    SortDedup,  ///< 按时间排序去重
+    Format,     ///< 生成输出行 / 列（不含写文件）
+    Compress,   ///< 压缩输出块（.gz / .zst，在压缩线程上）
+    Write,      ///< 写入输出文件
+    Count
+};
+
+/// 计数项
+enum class PerfCounter {
+    InputBytes,     ///< 解码的输入字节
+    Groups,         ///< 解码的组数
+    SkippedGroups,  ///< 时间字非法而跳过的组数
+    RowsWritten,    ///< 写出的数据行
+    OutputBytes,    ///< 写出的字节
+    Count
+};
+
+extern std::atomic<bool> g_perfEnabled;
+
+inline bool perfStatsEnabled()
+{
+    return g_perfEnabled.load(std::memory_order_relaxed);
+}
+
+/// 开启或关闭统计；trace 为 true 时同时记录每个计时区间，供导出 Chrome trace
+void setPerfStatsEnabled(bool enabled, bool trace = false);
+
+/// 清零所有统计，trace 的时间原点设为当前时刻
+void resetPerfStats();
+
+/// 累加计数（统计关闭时不做任何事）
+void perfCountSlow(PerfCounter counter, uint64_t value);
+inline void perfCount(PerfCounter counter, uint64_t value)
+{
+    if (perfStatsEnabled()) {
+        perfCountSlow(counter, value);
+    }
+}
+
+/**
+ * @brief PerfTimer
+ *  作用域计时：构造时开始，析构时计入阶段。统计关闭时不读时钟。
+ */
+class PerfTimer
+{
+public:
+    explicit PerfTimer(PerfStage stage)
+        : m_active(perfStatsEnabled())
+    {
+        if (m_active) {
+            begin(stage);
+        }
+    }
+    ~PerfTimer()
+    {
+        if (m_active) {
+            end();
+        }
+    }
+
+    PerfTimer(const PerfTimer &) = delete;
+    PerfTimer &operator=(const PerfTimer &) = delete;
+
+private:
+    void begin(PerfStage stage);
+    void end();
+
+    bool m_active;
+    PerfStage m_stage = PerfStage::Count;
+    std::chrono::steady_clock::time_point m_start;
+    uint64_t m_childNanos = 0;
+    PerfTimer *m_parent = nullptr;
+};
+
+/// 某一时刻的统计结果
+struct PerfSnapshot {
+    uint64_t stageNanos[(size_t)PerfStage::Count] = {};    ///< 各阶段自身耗时（各线程相加）
+    uint64_t stageCalls[(size_t)PerfStage::Count] = {};    ///< 各阶段计时次数
+    uint64_t counters[(size_t)PerfCounter::Count] = {};
+    uint64_t traceEvents = 0;       ///< 已记录的 trace 区间数
+    uint64_t droppedEvents = 0;     ///< 超出上限未记录的区间数
+};
+
+PerfSnapshot perfSnapshot();
+
+/// 阶段、计数项名称（英文，用于 JSON 与 trace）
+const char *perfStageName(PerfStage stage);
+const char *perfCounterName(PerfCounter counter);
+
+/// 多行文字汇总；wallSeconds 为整个转换的墙钟时间，用于计算吞吐，0 表示不计算
+std::string formatPerfSummary(const PerfSnapshot &snapshot, double wallSeconds = 0.0);
+
+/// 写出 JSON 汇总，失败时抛出 std::runtime_error
+void writePerfJson(const std::string &path, const PerfSnapshot &snapshot, double wallSeconds = 0.0);
+
+/// 写出 Chrome trace（chrome://tracing、Perfetto 可打开），需以 trace 模式开启统计；
+/// 失败时抛出 std::runtime_error
+void writeChromeTrace(const std::string &path);
+
+#endif // PERFSTATS_H
@@ -0,0 +1,85 @@
+#include "previewmodel.h"
+#include "csvwriter.h"
+
+#include <algorithm>
+#include <climits>
+
+PreviewModel::PreviewModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+void PreviewModel::open(const std::string &binFilename)
+{
+    std::unique_ptr<BinPreview> preview(new BinPreview(binFilename));
+    beginResetModel();
+    m_preview = std::move(preview);
+    endResetModel();
+}
+
+void PreviewModel::clear()
+{
+    beginResetModel();
+    m_preview.reset();
+    endResetModel();
+}
+
+int PreviewModel::rowCount(const QModelIndex &parent) const
+{
+    if (!m_preview || parent.isValid()) {
+        return 0;
+    }
+    // 视图的行号是 int，超大文件只显示前 INT_MAX 行
+    return (int)std::min<size_t>(m_preview->rowCount(), INT_MAX);
+}
+
+int PreviewModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : (int)(2 + kChannelCount);
+}
+
+QVariant PreviewModel::data(const QModelIndex &index, int role) const
+{
+    if (!m_preview || !index.isValid()) {
+        return QVariant();
+    }
+    if (role == Qt::TextAlignmentRole) {
+        return index.column() >= 2 ? QVariant(int(Qt::AlignRight | Qt::AlignVCenter)) : QVariant();
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    size_t row;
+    const RecordTable *table = m_preview->row((size_t)index.row(), row);
+    if (!table) {
+        return QVariant();
+    }
+    // 与 CSV 中的文本相同
+    char text[32];
+    size_t length;
+    if (index.column() == 0) {
+        length = formatDate(table->timestamps[row], text);
+    } else if (index.column() == 1) {
+        length = formatTime(table->timestamps[row], text);
+    } else {
+        length = (size_t)(formatFloat(text, table->columns[index.column() - 2][row]) - text);
+    }
+    return QString::fromUtf8(text, (int)length);
+}
+
+QVariant PreviewModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    if (orientation == Qt::Vertical) {
+        return QVariant(section + 1);
+    }
+    if (section == 0) {
+        return tr("日期");
+    }
+    if (section == 1) {
+        return tr("时间");
+    }
+    return QString::fromUtf8(kChannelNames[section - 2]);
+}
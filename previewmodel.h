@@ -0,0 +1,39 @@
+#ifndef PREVIEWMODEL_H
+#define PREVIEWMODEL_H
+
+#include <QAbstractTableModel>
+
+#include <memory>
+#include <string>
+
+#include "binpreview.h"
+
+/**
+ * @brief PreviewModel
+ *  bin 文件预览的表格模型：列为日期、时间与13个通道，同 CSV 表头。
+ *  视图只向模型请求可见的行，行数据由 BinPreview 按页解码并缓存，
+ *  几 GB 的文件也能立即打开、随意滚动。
+ */
+class PreviewModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewModel(QObject *parent = nullptr);
+
+    /// 预览 bin 文件，失败时抛出 std::runtime_error 且模型保持原来的内容
+    void open(const std::string &binFilename);
+    /// 清空预览
+    void clear();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    std::unique_ptr<BinPreview> m_preview;
+};
+
+#endif // PREVIEWMODEL_H
@@ -0,0 +1,220 @@
+#include "recordlayout.h"
+#include "recordtable.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+static const size_t kMaxBlockSize = 1 << 20;
+
+size_t RecordLayout::floatCount() const
+{
+    size_t used = floatStartIndex + (skipFirstGroupItem ? 1 : 0);
+    return groupSize > used ? groupSize - used : 0;
+}
+
+void RecordLayout::validate() const
+{
+    size_t itemCount = groupSize - (skipFirstGroupItem ? 1 : 0);
+    if (groupSize == 0 || itemCount < 2) {
+        throw std::runtime_error("布局无效：每组至少要有两个时间字");
+    }
+    if (initialBlockSize < 4 || (initialBlockSize - 4) % 4 != 0 || subsequentBlockSize % 4 != 0) {
+        throw std::runtime_error("布局无效：块大小必须是4的倍数，首块至少4字节");
+    }
+    if (initialBlockSize > kMaxBlockSize || subsequentBlockSize > kMaxBlockSize) {
+        throw std::runtime_error("布局无效：块过大");
+    }
+    if (subsequentBlockSize < groupBytes()) {
+        throw std::runtime_error("布局无效：后续块小于一组");
+    }
+    if (timeIndex[0] >= itemCount || timeIndex[1] >= itemCount) {
+        throw std::runtime_error("布局无效：时间字位置超出组长度");
+    }
+    if (floatCount() != kChannelCount) {
+        throw std::runtime_error("布局无效：每组必须正好有13个float");
+    }
+}
+
+std::string RecordLayout::toString() const
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "0x%llX/%zu/%zu/%zu/time=%zu,%zu/float=%zu/skip=%d",
+                  (unsigned long long)fileOffset, initialBlockSize, subsequentBlockSize,
+                  groupSize, timeIndex[0], timeIndex[1], floatStartIndex,
+                  skipFirstGroupItem ? 1 : 0);
+    return buf;
+}
+
+bool RecordLayout::operator==(const RecordLayout &o) const
+{
+    return fileOffset == o.fileOffset && initialBlockSize == o.initialBlockSize &&
+           subsequentBlockSize == o.subsequentBlockSize && groupSize == o.groupSize &&
+           timeIndex[0] == o.timeIndex[0] && timeIndex[1] == o.timeIndex[1] &&
+           floatStartIndex == o.floatStartIndex && skipFirstGroupItem == o.skipFirstGroupItem;
+}
+
+static std::string trim(const std::string &s)
+{
+    size_t b = 0, e = s.size();
+    while (b < e && std::isspace((unsigned char)s[b])) ++b;
+    while (e > b && std::isspace((unsigned char)s[e - 1])) --e;
+    return s.substr(b, e - b);
+}
+
+// 去掉成对的引号
+static std::string unquote(const std::string &s)
+{
+    if (s.size() >= 2 && (s.front() == '"' || s.front() == '\'') && s.back() == s.front()) {
+        return s.substr(1, s.size() - 2);
+    }
+    return s;
+}
+
+static uint64_t parseNumber(const std::string &key, const std::string &text)
+{
+    std::string s = unquote(trim(text));
+    errno = 0;
+    char *end = nullptr;
+    bool hex = s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X');
+    unsigned long long v = std::strtoull(s.c_str(), &end, hex ? 16 : 10);
+    if (s.empty() || s[0] == '-' || *end != '\0' || errno == ERANGE) {
+        throw std::runtime_error("布局参数 " + key + " 不是有效的数值：" + text);
+    }
+    return v;
+}
+
+static bool parseBool(const std::string &key, const std::string &text)
+{
+    std::string s = unquote(trim(text));
+    for (char &ch : s) {
+        ch = (char)std::tolower((unsigned char)ch);
+    }
+    if (s == "true" || s == "1" || s == "yes") return true;
+    if (s == "false" || s == "0" || s == "no") return false;
+    throw std::runtime_error("布局参数 " + key + " 不是有效的布尔值：" + text);
+}
+
+static void applyValue(RecordLayout &layout, const std::string &key, const std::string &value)
+{
+    if (key == "file_offset") {
+        layout.fileOffset = parseNumber(key, value);
+    } else if (key == "initial_block_size") {
+        layout.initialBlockSize = (size_t)parseNumber(key, value);
+    } else if (key == "subsequent_block_size") {
+        layout.subsequentBlockSize = (size_t)parseNumber(key, value);
+    } else if (key == "group_size") {
+        layout.groupSize = (size_t)parseNumber(key, value);
+    } else if (key == "float_hex_start_index") {
+        layout.floatStartIndex = (size_t)parseNumber(key, value);
+    } else if (key == "skip_first_group_item") {
+        layout.skipFirstGroupItem = parseBool(key, value);
+    } else if (key == "time_hex_indices" || key == "time_hex_indices_str") {
+        // [0, 1] 或 "0,1"
+        std::string s = unquote(trim(value));
+        if (!s.empty() && s.front() == '[' && s.back() == ']') {
+            s = s.substr(1, s.size() - 2);
+        }
+        size_t comma = s.find(',');
+        if (comma == std::string::npos || s.find(',', comma + 1) != std::string::npos) {
+            throw std::runtime_error("布局参数 " + key + " 必须是两个位置：" + value);
+        }
+        layout.timeIndex[0] = (size_t)parseNumber(key, s.substr(0, comma));
+        layout.timeIndex[1] = (size_t)parseNumber(key, s.substr(comma + 1));
+    } else if (key == "num_uint_initial" || key == "num_uint_subsequent") {
+        // GUI.py 中由块大小推出的冗余参数，忽略
+    } else {
+        throw std::runtime_error("未知的布局参数：" + key);
+    }
+}
+
+// 扁平 JSON 对象：按不在引号和方括号内的逗号切分成 "key": value
+static void parseJson(RecordLayout &layout, const std::string &text)
+{
+    std::string body = trim(text);
+    if (body.size() < 2 || body.front() != '{' || body.back() != '}') {
+        throw std::runtime_error("布局文件不是 JSON 对象");
+    }
+    body = body.substr(1, body.size() - 2);
+
+    std::vector<std::string> items;
+    std::string current;
+    bool inString = false;
+    int depth = 0;
+    for (char ch : body) {
+        if (ch == '"') {
+            inString = !inString;
+        } else if (!inString && ch == '[') {
+            ++depth;
+        } else if (!inString && ch == ']') {
+            --depth;
+        } else if (!inString && depth == 0 && ch == ',') {
+            items.push_back(current);
+            current.clear();
+            continue;
+        }
+        current += ch;
+    }
+    if (!trim(current).empty()) {
+        items.push_back(current);
+    }
+
+    for (const std::string &item : items) {
+        std::string s = trim(item);
+        if (s.empty() || s[0] != '"') {
+            throw std::runtime_error("布局文件格式错误：" + s);
+        }
+        size_t keyEnd = s.find('"', 1);
+        size_t colon = keyEnd == std::string::npos ? keyEnd : s.find(':', keyEnd);
+        if (colon == std::string::npos) {
+            throw std::runtime_error("布局文件格式错误：" + s);
+        }
+        applyValue(layout, s.substr(1, keyEnd - 1), s.substr(colon + 1));
+    }
+}
+
+static void parseIni(RecordLayout &layout, const std::string &text)
+{
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string s = trim(line);
+        if (s.empty() || s[0] == ';' || s[0] == '#' || s[0] == '[') {
+            continue;
+        }
+        size_t eq = s.find('=');
+        if (eq == std::string::npos) {
+            throw std::runtime_error("布局文件格式错误：" + s);
+        }
+        applyValue(layout, trim(s.substr(0, eq)), s.substr(eq + 1));
+    }
+}
+
+RecordLayout loadRecordLayout(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("无法打开布局文件：" + path);
+    }
+    std::ostringstream content;
+    content << in.rdbuf();
+    std::string text = content.str();
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+        text.erase(0, 3);
+    }
+
+    RecordLayout layout;
+    std::string head = trim(text);
+    if (!head.empty() && head[0] == '{') {
+        parseJson(layout, text);
+    } else {
+        parseIni(layout, text);
+    }
+    layout.validate();
+    return layout;
+}
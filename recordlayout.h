@@ -0,0 +1,57 @@
+#ifndef RECORDLAYOUT_H
+#define RECORDLAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief RecordLayout
+ *  bin 文件的记录布局，参数与 GUI.py 的解析配置一一对应。
+ *  文件先跳过 fileOffset 字节；首块 initialBlockSize 字节（开头一个 uint32 丢弃），
+ *  之后每块 subsequentBlockSize 字节。块内按 groupSize 个大端 uint32 分组，组不跨块，
+ *  块尾不足一组的部分忽略。组内（skipFirstGroupItem 时先去掉首字）timeIndex 处为两个
+ *  BCD 时间字，从 floatStartIndex 起到组末为 13 个 float。
+ *  默认值即当前控制器的 0xC0/132/128/16 布局。
+ */
+struct RecordLayout {
+    uint64_t fileOffset = 0xC0;
+    size_t initialBlockSize = 132;
+    size_t subsequentBlockSize = 128;
+    size_t groupSize = 16;
+    size_t timeIndex[2] = { 0, 1 };
+    size_t floatStartIndex = 2;
+    bool skipFirstGroupItem = true;
+
+    /// 每组字节数
+    size_t groupBytes() const { return groupSize * 4; }
+    /// 组内第 index 个字（已计入跳过的首字）的字节偏移
+    size_t wordOffset(size_t index) const { return (index + (skipFirstGroupItem ? 1 : 0)) * 4; }
+    /// 每组 float 个数
+    size_t floatCount() const;
+    /// 首块去掉开头 uint32 后是否与后续块不等长（需单独解析）
+    bool separateHead() const { return initialBlockSize - 4 != subsequentBlockSize; }
+    /// 等长块序列的起始偏移：首块单独解析时在首块之后，否则在丢弃的 uint32 之后
+    uint64_t dataOffset() const { return fileOffset + (separateHead() ? initialBlockSize : 4); }
+
+    /// 参数不合法（块小于一组、时间字或 float 越界、float 不是13个等）时抛出 std::runtime_error
+    void validate() const;
+
+    /// 单行文本描述，用于日志与断点文件
+    std::string toString() const;
+
+    bool operator==(const RecordLayout &other) const;
+    bool operator!=(const RecordLayout &other) const { return !(*this == other); }
+};
+
+/**
+ * @brief loadRecordLayout
+ *  从 JSON（扁平对象）或 INI（key = value，忽略节名与 ; # 注释）文件读取布局，
+ *  键名与 GUI.py 相同：file_offset、initial_block_size、subsequent_block_size、group_size、
+ *  time_hex_indices（[0,1] 或 "0,1"）、float_hex_start_index、skip_first_group_item。
+ *  未给出的键取默认值；数值可写十进制或 0x 十六进制。
+ *  读取失败、键未知或取值不合法时抛出 std::runtime_error。
+ */
+RecordLayout loadRecordLayout(const std::string &path);
+
+#endif // RECORDLAYOUT_H
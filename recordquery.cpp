@@ -0,0 +1,82 @@
+#include "recordquery.h"
+
+#include <cstdlib>
+#include <stdexcept>
+
+// 读取恰好 digits 位十进制数，成功时前移 p
+static bool readNumber(const char *&p, int digits, int &value)
+{
+    value = 0;
+    for (int i = 0; i < digits; ++i) {
+        if (p[i] < '0' || p[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (p[i] - '0');
+    }
+    p += digits;
+    return true;
+}
+
+static bool isLeapYear(int year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+uint64_t parseTimestampText(const std::string &text)
+{
+    static const int kDays[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    const char *p = text.c_str();
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    bool ok = readNumber(p, 4, year);
+    char sep = *p;
+    ok = ok && (sep == '-' || sep == '/') && *p++ == sep && readNumber(p, 2, month) &&
+         *p++ == sep && readNumber(p, 2, day);
+    if (ok && (*p == ' ' || *p == 'T')) {
+        ++p;
+        ok = readNumber(p, 2, hour) && *p++ == ':' && readNumber(p, 2, minute);
+        if (ok && *p == ':') {
+            ++p;
+            ok = readNumber(p, 2, second);
+        }
+    }
+    ok = ok && *p == '\0' && month >= 1 && month <= 12 && day >= 1 &&
+         day <= kDays[month - 1] + (month == 2 && isLeapYear(year) ? 1 : 0) &&
+         hour <= 23 && minute <= 59 && second <= 59;
+    if (!ok) {
+        throw std::runtime_error("无效的时间（应为 YYYY-MM-DD hh:mm:ss）：" + text);
+    }
+    return packTimestamp(year, month, day, hour, minute, second);
+}
+
+uint32_t parseColumnList(const std::string &text)
+{
+    uint32_t mask = 0;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        size_t stop = comma == std::string::npos ? text.size() : comma;
+        std::string item = text.substr(start, stop - start);
+        start = stop + 1;
+
+        size_t column = kChannelCount;
+        char *end = nullptr;
+        long n = std::strtol(item.c_str(), &end, 10);
+        if (!item.empty() && *end == '\0') {
+            if (n >= 1 && n <= (long)kChannelCount) {
+                column = (size_t)(n - 1);
+            }
+        } else {
+            for (size_t c = 0; c < kChannelCount; ++c) {
+                if (item == kChannelNames[c]) {
+                    column = c;
+                    break;
+                }
+            }
+        }
+        if (column == kChannelCount) {
+            throw std::runtime_error("无法识别的列：" + item);
+        }
+        mask |= 1u << column;
+    }
+    return mask;
+}
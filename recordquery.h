@@ -0,0 +1,43 @@
+#ifndef RECORDQUERY_H
+#define RECORDQUERY_H
+
+#include <cstdint>
+#include <string>
+
+#include "recordtable.h"
+
+/**
+ * @brief RecordQuery
+ *  解析时下推的查询：时间范围 [begin, end)（打包时间戳）与要输出的列。
+ *  范围外的行和未选中的列不解码、不写出。bin 旁没有有效的 .bidx 索引时，内存映射的文件
+ *  先逐组读一遍时间字找出含范围内时间的块（乱序输入同样准确），并写出索引；
+ *  之后的查询按索引只读相关的块。
+ */
+struct RecordQuery {
+    uint64_t begin = 0;                 ///< 起始时间（含）
+    uint64_t end = UINT64_MAX;          ///< 结束时间（不含）
+    uint32_t columnMask = kAllColumns;  ///< 输出的列（按位，列顺序同 CSV 表头）
+
+    bool hasTimeRange() const { return begin != 0 || end != UINT64_MAX; }
+    bool projected() const { return columnMask != kAllColumns; }
+    /// 有任一限制时返回 true；否则解析走不带查询的路径
+    bool active() const { return hasTimeRange() || projected(); }
+    bool contains(uint64_t ts) const { return ts >= begin && ts < end; }
+};
+
+/**
+ * @brief parseTimestampText
+ *  解析 "YYYY-MM-DD[ hh:mm[:ss]]"（日期也可用 '/' 分隔，日期与时间之间也可用 'T'）
+ *  为打包时间戳，省略的时间部分为0。格式或取值非法时抛出 std::runtime_error。
+ */
+uint64_t parseTimestampText(const std::string &text);
+
+/**
+ * @brief parseColumnList
+ *  解析逗号分隔的列表为列掩码；每项为通道序号（1-13，即 CSV 中时间之后的第几列）
+ *  或与表头一致的通道名。输出列总按表头顺序排列，与列表顺序无关。
+ *  列表为空或某项无法识别时抛出 std::runtime_error。
+ */
+uint32_t parseColumnList(const std::string &text);
+
+#endif // RECORDQUERY_H
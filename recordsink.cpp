@@ -0,0 +1,34 @@
+#include "recordsink.h"
+#include "aggregatesink.h"
+#include "arrowwriter.h"
+#include "csvwriter.h"
+
+const char *outputExtension(OutputFormat format)
+{
+    switch (format) {
+    case OutputFormat::Arrow:
+        return ".arrow";
+    case OutputFormat::Csv:
+        break;
+    }
+    return ".csv";
+}
+
+std::unique_ptr<RecordSink> openRecordSink(const std::string &filename, OutputFormat format,
+                                           CsvEncoding encoding, uint32_t columnMask,
+                                           const Aggregation *aggregation)
+{
+    std::unique_ptr<RecordSink> sink;
+    switch (format) {
+    case OutputFormat::Arrow:
+        sink.reset(new ArrowWriter(filename, kArrowBatchRows, columnMask));
+        break;
+    case OutputFormat::Csv:
+        sink.reset(new CsvWriter(filename, encoding, false, columnMask));
+        break;
+    }
+    if (aggregation && aggregation->active()) {
+        sink.reset(new AggregateSink(std::move(sink), *aggregation));
+    }
+    return sink;
+}
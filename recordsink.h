@@ -0,0 +1,51 @@
+#ifndef RECORDSINK_H
+#define RECORDSINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "recordtable.h"
+
+enum class CsvEncoding;
+struct Aggregation;
+
+/// 输出文件格式
+enum class OutputFormat {
+    Csv,    ///< 文本 CSV（日期,时间,各通道）
+    Arrow,  ///< Arrow IPC 文件（即 Feather v2），时间戳 + 13列 float32
+};
+
+/// 输出格式对应的文件后缀（含'.'）
+const char *outputExtension(OutputFormat format);
+
+/**
+ * @brief RecordSink
+ *  按时间顺序接收去重后的记录行的输出端。writeHeader 在第一行之前调用，
+ *  close 刷新并关闭文件，失败时抛出 std::runtime_error。
+ */
+class RecordSink
+{
+public:
+    virtual ~RecordSink() {}
+
+    virtual void writeHeader() = 0;
+    /// 写一行：打包时间戳 + count 个按表头顺序排列的值
+    virtual void writeRow(uint64_t ts, const float *values, size_t count) = 0;
+    virtual void close() = 0;
+};
+
+/**
+ * @brief openRecordSink
+ *  按格式创建输出文件，只含 columnMask 中的通道列（每行的值依次为这些列）。
+ *  文件名以 .gz / .zst 结尾时压缩写出（见 OutputFile）。
+ *  encoding 只对 CSV 有效。aggregation 非空且有效时外面套一层 AggregateSink，
+ *  按时间窗口聚合后写出。无法创建时抛出 std::runtime_error。
+ */
+std::unique_ptr<RecordSink> openRecordSink(const std::string &filename, OutputFormat format,
+                                           CsvEncoding encoding,
+                                           uint32_t columnMask = kAllColumns,
+                                           const Aggregation *aggregation = nullptr);
+
+#endif // RECORDSINK_H
@@ -0,0 +1,154 @@
+#include "recordtable.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+const char *const kChannelNames[kChannelCount] = {
+    "压力设定/mbar", "实际压力/mbar",
+    "设定温度/℃",   "实际温度/℃",
+    "设定功率/KW",   "实际功率/KW",
+    "加热电阻/mΩ",   "加热电压/V",
+    "加热电流/A",    "毫托计/Pa",
+    "氩气流量/SLM",  "温升/℃/min",
+    "氟利昂流量/SLM",
+};
+
+static inline char *put2(char *p, int v)
+{
+    p[0] = (char)('0' + v / 10);
+    p[1] = (char)('0' + v % 10);
+    return p + 2;
+}
+
+size_t formatDate(uint64_t ts, char *buf)
+{
+    int year = timestampYear(ts);
+    char *p = buf;
+    p = put2(p, year / 100);
+    p = put2(p, year % 100);
+    *p++ = '/';
+    p = put2(p, timestampMonth(ts));
+    *p++ = '/';
+    p = put2(p, timestampDay(ts));
+    *p = '\0';
+    return (size_t)(p - buf);
+}
+
+size_t formatTime(uint64_t ts, char *buf)
+{
+    char *p = buf;
+    p = put2(p, timestampHour(ts));
+    *p++ = ':';
+    p = put2(p, timestampMinute(ts));
+    *p++ = ':';
+    p = put2(p, timestampSecond(ts));
+    *p = '\0';
+    return (size_t)(p - buf);
+}
+
+int64_t timestampToEpochSeconds(uint64_t ts)
+{
+    // 公历日期到 1970-01-01 的天数（Howard Hinnant 的 days_from_civil）
+    int64_t y = timestampYear(ts);
+    int64_t m = timestampMonth(ts);
+    int64_t d = timestampDay(ts);
+    y -= (m <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + doe - 719468;
+    return days * 86400 + timestampHour(ts) * 3600 + timestampMinute(ts) * 60 + timestampSecond(ts);
+}
+
+bool sortRowOrder(const uint64_t *keys, size_t count, std::vector<uint32_t> &order)
+{
+    PerfTimer timer(PerfStage::SortDedup);
+    order.clear();
+    bool sorted = true;
+    for (size_t i = 1; i < count; ++i) {
+        if (keys[i] < keys[i - 1]) {
+            sorted = false;
+            break;
+        }
+    }
+    if (sorted) {
+        return false;
+    }
+
+    if (count > UINT32_MAX) {
+        throw std::runtime_error("记录数过多，无法排序");
+    }
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = (uint32_t)i;
+    }
+    std::stable_sort(order.begin(), order.end(), [keys](uint32_t a, uint32_t b){
+        return keys[a] < keys[b];
+    });
+    return true;
+}
+
+void RecordTable::clear()
+{
+    timestamps.clear();
+    for (auto &col : columns) {
+        col.clear();
+    }
+    columnMask = kAllColumns;
+}
+
+void RecordTable::reserve(size_t rows)
+{
+    timestamps.reserve(rows);
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if (hasColumn(c)) {
+            columns[c].reserve(rows);
+        }
+    }
+}
+
+void RecordTable::resize(size_t rows)
+{
+    timestamps.resize(rows);
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if (hasColumn(c)) {
+            columns[c].resize(rows);
+        }
+    }
+}
+
+void RecordTable::moveRows(size_t from, size_t count, size_t to)
+{
+    if (from == to || count == 0) {
+        return;
+    }
+    std::copy(timestamps.begin() + from, timestamps.begin() + from + count, timestamps.begin() + to);
+    for (auto &col : columns) {
+        if (!col.empty()) {
+            std::copy(col.begin() + from, col.begin() + from + count, col.begin() + to);
+        }
+    }
+}
+
+void RecordTable::append(uint64_t ts, const float *values)
+{
+    timestamps.push_back(ts);
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        if (hasColumn(c)) {
+            columns[c].push_back(*values++);
+        }
+    }
+}
+
+void RecordTable::append(const RecordTable &other)
+{
+    if (other.columnMask != columnMask) {
+        throw std::runtime_error("追加的记录表列不一致");
+    }
+    timestamps.insert(timestamps.end(), other.timestamps.begin(), other.timestamps.end());
+    for (size_t c = 0; c < kChannelCount; ++c) {
+        columns[c].insert(columns[c].end(), other.columns[c].begin(), other.columns[c].end());
+    }
+}
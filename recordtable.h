@@ -0,0 +1,115 @@
+#ifndef RECORDTABLE_H
+#define RECORDTABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// 每条记录的浮点通道数
+static const size_t kChannelCount = 13;
+
+/// 通道名称，按 CSV 表头（即 RecordTable 列）的顺序
+extern const char *const kChannelNames[kChannelCount];
+
+/// 全部通道的列掩码（第 c 位对应第 c 列）
+static const uint32_t kAllColumns = (1u << kChannelCount) - 1;
+
+/// 列掩码中的列数
+inline size_t columnCount(uint32_t mask)
+{
+    size_t n = 0;
+    for (; mask; mask &= mask - 1) {
+        ++n;
+    }
+    return n;
+}
+
+/**
+ * @brief packTimestamp
+ *  将日期时间打包成64位键：年(16位)|月|日|时|分|秒(各8位)。
+ *  键的数值大小即时间先后，可直接比较、排序、去重。
+ */
+inline uint64_t packTimestamp(int year, int month, int day,
+                              int hour, int minute, int second)
+{
+    return ((uint64_t)year << 40) | ((uint64_t)month << 32) | ((uint64_t)day << 24) |
+           ((uint64_t)hour << 16) | ((uint64_t)minute << 8) | (uint64_t)second;
+}
+
+inline int timestampYear(uint64_t ts)   { return (int)(ts >> 40); }
+inline int timestampMonth(uint64_t ts)  { return (int)((ts >> 32) & 0xFF); }
+inline int timestampDay(uint64_t ts)    { return (int)((ts >> 24) & 0xFF); }
+inline int timestampHour(uint64_t ts)   { return (int)((ts >> 16) & 0xFF); }
+inline int timestampMinute(uint64_t ts) { return (int)((ts >> 8) & 0xFF); }
+inline int timestampSecond(uint64_t ts) { return (int)(ts & 0xFF); }
+
+/// 转为自 1970-01-01 00:00:00 起的秒数（按不带时区的本地时间计）
+int64_t timestampToEpochSeconds(uint64_t ts);
+
+/// 格式化日期 "YYYY/MM/DD"，buf 至少11字节，返回写入长度（不含结尾0）
+size_t formatDate(uint64_t ts, char *buf);
+/// 格式化时间 "hh:mm:ss"，buf 至少9字节，返回写入长度（不含结尾0）
+size_t formatTime(uint64_t ts, char *buf);
+
+/**
+ * @brief sortRowOrder
+ *  计算按时间戳稳定排序的行序号。keys 已按时间非降序时不排序，返回 false
+ *  且 order 为空（按原顺序即可）；否则返回 true，order 为排序后的行序号。
+ *  行数超出 uint32 范围时抛出 std::runtime_error。
+ */
+bool sortRowOrder(const uint64_t *keys, size_t count, std::vector<uint32_t> &order);
+
+/**
+ * @brief RecordTable
+ *  列式存储的解析结果：一列打包时间戳 + 13列连续 float。
+ *  列顺序与 CSV 表头一致（原始数据中最后两个通道在解析时已交换）。
+ *  按列投影解析时只保存 columnMask 中的列，其余列为空。
+ *  日期、时间文本只在写出时生成。
+ */
+struct RecordTable {
+    std::vector<uint64_t> timestamps;
+    std::array<std::vector<float>, kChannelCount> columns;
+    uint32_t columnMask = kAllColumns;  ///< 保存的列，只在表为空时修改
+
+    size_t size() const { return timestamps.size(); }
+    bool empty() const { return timestamps.empty(); }
+    bool hasColumn(size_t c) const { return (columnMask >> c) & 1; }
+
+    /// 将第 i 行保存的各列按列顺序写入 values（至少 kChannelCount 个），返回列数
+    size_t gatherRow(size_t i, float *values) const
+    {
+        size_t n = 0;
+        for (size_t c = 0; c < kChannelCount; ++c) {
+            if (hasColumn(c)) {
+                values[n++] = columns[c][i];
+            }
+        }
+        return n;
+    }
+
+    /// 清空所有行，保留已分配的容量；保存的列恢复为全部列
+    void clear();
+    void reserve(size_t rows);
+    /// 调整行数，新增行的内容未定义（由调用方填写）
+    void resize(size_t rows);
+    /// 将 [from, from+count) 行移动到 to 开始处（to <= from）
+    void moveRows(size_t from, size_t count, size_t to);
+
+    /// 追加一行，values 为保存的各列按列顺序排列的值（同 gatherRow）
+    void append(uint64_t ts, const float *values);
+    /// 追加另一张表的全部行，两表保存的列须相同
+    void append(const RecordTable &other);
+};
+
+/// 表保留的堆内存字节数（供 RecyclePool 限制空闲表的总量）
+inline size_t recycleBytes(const RecordTable &table)
+{
+    size_t bytes = table.timestamps.capacity() * sizeof(uint64_t);
+    for (const auto &col : table.columns) {
+        bytes += col.capacity() * sizeof(float);
+    }
+    return bytes;
+}
+
+#endif // RECORDTABLE_H
@@ -0,0 +1,125 @@
+#ifndef RECYCLEPOOL_H
+#define RECYCLEPOOL_H
+
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/// 对象保留的堆内存字节数（RecyclePool 按此限制空闲对象的总量）；
+/// 其他类型在各自的头文件中提供同名重载
+template <typename U>
+inline size_t recycleBytes(const std::vector<U> &v)
+{
+    return v.capacity() * sizeof(U);
+}
+
+/**
+ * @brief RecyclePool
+ *  可复用对象池：归还的对象 clear() 后保留已分配的容量，下次 acquire() 直接取回，
+ *  逐个文件转换时不必每次重新分配几十 MB 的表、也不再重新触发缺页。
+ *  按值取出与归还（只移动，不复制内容）；线程安全，每个文件或输出只取还一次，
+ *  锁不在逐行的热路径上。
+ *  空闲对象最多保留 maxIdle 个、共 maxIdleBytes 字节，超出的直接释放。
+ */
+template <typename T>
+class RecyclePool
+{
+public:
+    explicit RecyclePool(size_t maxIdle = 8, size_t maxIdleBytes = (size_t)256 << 20)
+        : m_maxIdle(maxIdle)
+        , m_maxIdleBytes(maxIdleBytes)
+    {
+    }
+
+    RecyclePool(const RecyclePool &) = delete;
+    RecyclePool &operator=(const RecyclePool &) = delete;
+
+    /// 取一个空对象，优先复用容量最大的空闲对象
+    T acquire()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_idle.empty()) {
+            return T();
+        }
+        T object = std::move(m_idle.back());
+        m_idle.pop_back();
+        m_idleBytes -= recycleBytes(object);
+        return object;
+    }
+
+    /// 归还对象，内容被清空；池已满时直接释放
+    void release(T &&object)
+    {
+        object.clear();
+        size_t bytes = recycleBytes(object);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (bytes == 0 || m_idle.size() >= m_maxIdle || m_idleBytes + bytes > m_maxIdleBytes) {
+            return;
+        }
+        // 按容量升序排列，acquire 从末尾取最大的
+        auto pos = m_idle.begin();
+        while (pos != m_idle.end() && recycleBytes(*pos) < bytes) {
+            ++pos;
+        }
+        m_idle.insert(pos, std::move(object));
+        m_idleBytes += bytes;
+    }
+
+    /// 释放全部空闲对象
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idle.clear();
+        m_idleBytes = 0;
+    }
+
+    size_t idleCount() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_idle.size();
+    }
+
+    size_t idleBytes() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_idleBytes;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<T> m_idle;
+    size_t m_idleBytes = 0;
+    size_t m_maxIdle;
+    size_t m_maxIdleBytes;
+};
+
+/// 从池中借出一个对象，析构时归还；pool 为空时就是一个普通对象
+template <typename T>
+class Recycled
+{
+public:
+    explicit Recycled(RecyclePool<T> *pool)
+        : m_pool(pool)
+        , m_object(pool ? pool->acquire() : T())
+    {
+    }
+    ~Recycled()
+    {
+        if (m_pool) {
+            m_pool->release(std::move(m_object));
+        }
+    }
+
+    Recycled(const Recycled &) = delete;
+    Recycled &operator=(const Recycled &) = delete;
+
+    T &operator*() { return m_object; }
+    T *operator->() { return &m_object; }
+
+private:
+    RecyclePool<T> *m_pool;
+    T m_object;
+};
+
+#endif // RECYCLEPOOL_H
@@ -0,0 +1,406 @@
+#include "resultcache.h"
+#include "blockindex.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+// ---- XXH64 ----
+
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t readLe64(const unsigned char *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+static inline uint32_t readLe32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t xxRound(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    return rotl64(acc, 31) * kPrime1;
+}
+
+static inline uint64_t xxMergeRound(uint64_t acc, uint64_t value)
+{
+    acc ^= xxRound(0, value);
+    return acc * kPrime1 + kPrime4;
+}
+
+uint64_t xxHash64(const void *data, size_t size, uint64_t seed)
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    const unsigned char *end = p + size;
+    uint64_t h;
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        for (; p + 32 <= end; p += 32) {
+            v1 = xxRound(v1, readLe64(p));
+            v2 = xxRound(v2, readLe64(p + 8));
+            v3 = xxRound(v3, readLe64(p + 16));
+            v4 = xxRound(v4, readLe64(p + 24));
+        }
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxMergeRound(h, v1);
+        h = xxMergeRound(h, v2);
+        h = xxMergeRound(h, v3);
+        h = xxMergeRound(h, v4);
+    } else {
+        h = seed + kPrime5;
+    }
+    h += (uint64_t)size;
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxRound(0, readLe64(p));
+        h = rotl64(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)readLe32(p) * kPrime1;
+        h = rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (uint64_t)*p * kPrime5;
+        h = rotl64(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ---- 缓存 ----
+
+static bool seekTo(FILE *fp, uint64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(fp, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+static std::string hexKey(uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016" PRIx64, value);
+    return text;
+}
+
+// 输出文件的大小与修改时间（输出可能是 .gz 等，不能用 binFileStamp）
+static bool outputStamp(const std::string &path, uint64_t &size, int64_t &mtime)
+{
+    std::error_code ec;
+    size = fs::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    mtime = (int64_t)fs::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+// 先写临时文件再改名，读者不会看到写了一半的内容
+static bool writeTextFile(const std::string &path, const std::string &text)
+{
+    std::string tmp = path + ".tmp";
+    FILE *fp = std::fopen(tmp.c_str(), "w");
+    if (!fp) {
+        return false;
+    }
+    bool ok = std::fwrite(text.data(), 1, text.size(), fp) == text.size();
+    ok = std::fclose(fp) == 0 && ok;
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmp, path, ec);
+    }
+    if (!ok || ec) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+ResultCache::ResultCache(const std::string &dir, uint64_t maxBytes)
+    : m_dir(dir)
+    , m_maxBytes(maxBytes)
+{
+}
+
+bool ResultCache::ensureDir() const
+{
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+    return !ec;
+}
+
+bool ResultCache::key(const std::string &binPath, const std::string &options, std::string &key)
+{
+    uint64_t size;
+    int64_t mtime;
+    if (!binFileStamp(binPath, size, mtime)) {
+        return false;
+    }
+    // 大小、修改时间、文件头与文件尾的取样拼在一起哈希；小文件头尾重叠也无妨
+    std::vector<unsigned char> sample(16 + 2 * kCacheSampleBytes);
+    std::memcpy(sample.data(), &size, 8);
+    std::memcpy(sample.data() + 8, &mtime, 8);
+    FILE *fp = std::fopen(binPath.c_str(), "rb");
+    if (!fp) {
+        return false;
+    }
+    size_t n = std::fread(sample.data() + 16, 1, kCacheSampleBytes, fp);
+    uint64_t tail = size > kCacheSampleBytes ? size - kCacheSampleBytes : 0;
+    if (seekTo(fp, tail)) {
+        n += std::fread(sample.data() + 16 + n, 1, kCacheSampleBytes, fp);
+    }
+    std::fclose(fp);
+
+    uint64_t input = xxHash64(sample.data(), 16 + n);
+    key = hexKey(xxHash64(options.data(), options.size(), input));
+    return true;
+}
+
+// 按路径区分的记录文件：<prefix>-<绝对路径的 XXH64>.txt
+std::string ResultCache::recordPath(const char *prefix, const std::string &path) const
+{
+    std::error_code ec;
+    std::string absolute = fs::absolute(path, ec).lexically_normal().string();
+    if (ec) {
+        absolute = path;
+    }
+    return (fs::path(m_dir) / (std::string(prefix) + "-" +
+                               hexKey(xxHash64(absolute.data(), absolute.size())) +
+                               ".txt")).string();
+}
+
+std::string ResultCache::runPath(const std::string &key, size_t index) const
+{
+    return (fs::path(m_dir) / (key + "-" + std::to_string(index) + ".run")).string();
+}
+
+bool ResultCache::outputMatches(const std::string &output, const std::string &key) const
+{
+    uint64_t size;
+    int64_t mtime;
+    if (!outputStamp(output, size, mtime)) {
+        return false;
+    }
+    FILE *fp = std::fopen(recordPath("out", output).c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    char storedKey[32] = {};
+    uint64_t storedSize = 0;
+    int64_t storedMtime = 0;
+    bool ok = std::fscanf(fp, "%31s %" SCNu64 " %" SCNd64, storedKey, &storedSize,
+                          &storedMtime) == 3;
+    std::fclose(fp);
+    return ok && key == storedKey && storedSize == size && storedMtime == mtime;
+}
+
+void ResultCache::storeOutput(const std::string &output, const std::string &key) const
+{
+    uint64_t size;
+    int64_t mtime;
+    if (!outputStamp(output, size, mtime) || !ensureDir()) {
+        return;
+    }
+    char text[64];
+    std::snprintf(text, sizeof(text), " %" PRIu64 " %" PRId64 "\n", size, mtime);
+    writeTextFile(recordPath("out", output), key + text);
+}
+
+// 清单为段数及各段的字节数
+bool ResultCache::readManifest(const std::string &key, std::vector<uint64_t> &sizes) const
+{
+    FILE *fp = std::fopen((fs::path(m_dir) / (key + ".runs")).string().c_str(), "r");
+    if (!fp) {
+        return false;
+    }
+    size_t count = 0;
+    bool ok = std::fscanf(fp, "%zu", &count) == 1;
+    sizes.clear();
+    for (size_t i = 0; ok && i < count; ++i) {
+        uint64_t bytes = 0;
+        ok = std::fscanf(fp, "%" SCNu64, &bytes) == 1;
+        sizes.push_back(bytes);
+    }
+    std::fclose(fp);
+    return ok;
+}
+
+bool ResultCache::findRuns(const std::string &key, std::vector<std::string> &runs)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 段不全或被截断时视为没有缓存
+    std::vector<uint64_t> sizes;
+    if (!readManifest(key, sizes)) {
+        return false;
+    }
+    std::vector<std::string> found;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        std::error_code ec;
+        found.push_back(runPath(key, i));
+        if (fs::file_size(found.back(), ec) != sizes[i] || ec) {
+            return false;
+        }
+    }
+    // 清单的修改时间即最近使用时间，供 prune 排序
+    std::error_code ec;
+    fs::last_write_time(fs::path(m_dir) / (key + ".runs"), fs::file_time_type::clock::now(), ec);
+    m_pinned.insert(key);
+    runs.swap(found);
+    return true;
+}
+
+bool ResultCache::storeRuns(const std::string &key, const std::string &source,
+                            std::vector<std::string> &runs)
+{
+    if (!ensureDir()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pinned.insert(key);
+    }
+    for (size_t i = 0; i < runs.size(); ++i) {
+        std::string path = runPath(key, i);
+        std::error_code ec;
+        fs::rename(runs[i], path, ec);
+        if (ec) {
+            // 临时目录与缓存不在同一文件系统时只能复制
+            ec.clear();
+            fs::copy_file(runs[i], path, fs::copy_options::overwrite_existing, ec);
+            if (ec) {
+                return false;
+            }
+            std::remove(runs[i].c_str());
+        }
+        runs[i] = path;
+    }
+    // 清单最后写出：有清单即表示各段完整
+    std::string manifest = std::to_string(runs.size()) + "\n";
+    for (const std::string &path : runs) {
+        std::error_code ec;
+        uint64_t bytes = fs::file_size(path, ec);
+        if (ec) {
+            return false;
+        }
+        manifest += std::to_string(bytes) + "\n";
+    }
+    if (!writeTextFile((fs::path(m_dir) / (key + ".runs")).string(), manifest)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    replaceSource(source, key);
+    if (m_maxBytes != 0) {
+        prune();
+    }
+    return true;
+}
+
+// 记下 source 当前的键，删除它此前的键的段（调用方持有 m_mutex）
+void ResultCache::replaceSource(const std::string &source, const std::string &key)
+{
+    std::string record = recordPath("src", source);
+    char previous[32] = {};
+    if (FILE *fp = std::fopen(record.c_str(), "r")) {
+        if (std::fscanf(fp, "%31s", previous) != 1) {
+            previous[0] = '\0';
+        }
+        std::fclose(fp);
+    }
+    if (key == previous) {
+        return;
+    }
+    if (previous[0] != '\0') {
+        removeRuns(previous);
+    }
+    writeTextFile(record, key + "\n");
+}
+
+// 删除 key 的整组段：先删清单，中途失败时剩下的段不会再被当作缓存（调用方持有 m_mutex）
+void ResultCache::removeRuns(const std::string &key)
+{
+    std::vector<uint64_t> sizes;
+    if (m_pinned.count(key) || !readManifest(key, sizes)) {
+        return;
+    }
+    std::remove((fs::path(m_dir) / (key + ".runs")).string().c_str());
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        std::remove(runPath(key, i).c_str());
+    }
+}
+
+// 段的总大小超出 m_maxBytes 时按清单修改时间从旧到新删除（调用方持有 m_mutex）
+void ResultCache::prune()
+{
+    struct Entry {
+        fs::file_time_type used;
+        std::string key;
+        uint64_t bytes;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (const fs::directory_entry &file : fs::directory_iterator(m_dir, ec)) {
+        if (file.path().extension() != ".runs") {
+            continue;
+        }
+        std::string key = file.path().stem().string();
+        std::vector<uint64_t> sizes;
+        std::error_code timeError;
+        fs::file_time_type used = file.last_write_time(timeError);
+        if (timeError || !readManifest(key, sizes)) {
+            continue;
+        }
+        uint64_t bytes = 0;
+        for (uint64_t size : sizes) {
+            bytes += size;
+        }
+        total += bytes;
+        entries.push_back(Entry{ used, key, bytes });
+    }
+    if (total <= m_maxBytes) {
+        return;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b){
+        return a.used < b.used;
+    });
+    for (const Entry &entry : entries) {
+        if (total <= m_maxBytes) {
+            break;
+        }
+        if (!m_pinned.count(entry.key)) {
+            removeRuns(entry.key);
+            total -= entry.bytes;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/// 计算输入指纹时从文件头、文件尾各取样的字节数
+static const size_t kCacheSampleBytes = 64 << 10;
+
+/// XXH64 哈希
+uint64_t xxHash64(const void *data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief ResultCache
+ *  转换结果缓存，保存在 dir 目录下，可随时整个删除：
+ *  - 分别输出：记下每个输出文件对应的键与输出文件的大小、修改时间，
+ *    再次转换时输出未被改动且键相同即直接跳过；
+ *  - 合并输出：每个输入文件解析、排序后的有序段（见 RunWriter）移入缓存，
+ *    之后的合并只需解析新的文件，再与缓存的段一起归并。
+ *  键由输入指纹（大小、修改时间与文件头尾各 kCacheSampleBytes 字节的 XXH64）
+ *  与影响结果的选项描述组成；只有普通文件有指纹，压缩输入、zip 项与标准输入不缓存。
+ *  缓存只是加速：读写失败时照常转换，不报错。可在多个线程中同时使用（键不同时）。
+ *
+ *  有序段与解析结果一样大，目录大小按以下规则限制：
+ *  - 每个输入文件只保留最新的一组段：同一路径存入新键的段时，旧键的段随即删除；
+ *  - maxBytes 非0时，存入后所有段的总大小超出即按最近使用时间从旧到新删除整组段。
+ *  本对象查到或存入过的键在其生存期内不会被删除（合并时仍要读这些段）。
+ *  分别输出只记录输出路径与键的对应，每个输出一个小文件，新记录覆盖旧记录。
+ */
+class ResultCache
+{
+public:
+    explicit ResultCache(const std::string &dir, uint64_t maxBytes = 0);
+
+    /// 输入文件与选项描述的键（16位十六进制）；输入没有指纹时返回 false
+    static bool key(const std::string &binPath, const std::string &options, std::string &key);
+
+    /// output 存在、未被改动，且是 key 对应的结果
+    bool outputMatches(const std::string &output, const std::string &key) const;
+    /// 记录 output 当前的内容为 key 的结果
+    void storeOutput(const std::string &output, const std::string &key) const;
+
+    /// key 对应的缓存段（按原顺序），同时记为最近使用；没有时返回 false
+    bool findRuns(const std::string &key, std::vector<std::string> &runs);
+    /// 把输入文件 source 刚写出的有序段移入缓存并记为 key 的结果，runs 改为缓存中的路径；
+    /// 之后删除 source 此前的段，并按 maxBytes 删除最久未用的段。
+    /// 失败时返回 false，已移动的段仍在 runs 中给出的位置
+    bool storeRuns(const std::string &key, const std::string &source,
+                   std::vector<std::string> &runs);
+
+private:
+    std::string recordPath(const char *prefix, const std::string &path) const;
+    std::string runPath(const std::string &key, size_t index) const;
+    bool readManifest(const std::string &key, std::vector<uint64_t> &sizes) const;
+    void replaceSource(const std::string &source, const std::string &key);
+    void removeRuns(const std::string &key);
+    void prune();
+    bool ensureDir() const;
+
+    std::string m_dir;
+    uint64_t m_maxBytes;
+    std::mutex m_mutex;                 ///< 保护 m_pinned 与段的删除
+    std::set<std::string> m_pinned;     ///< 本次查到或存入的键，不删除
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,271 @@
+#include "spillrun.h"
+#include "recordsink.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+
+static const size_t kRunBufferRows = 4096;
+/// 段文件头：格式标记 + uint32 列掩码
+static const char kRunMagic[4] = { 'B', 'R', 'U', '1' };
+static const size_t kRunHeaderBytes = sizeof(kRunMagic) + sizeof(uint32_t);
+
+static inline size_t runRowBytes(uint32_t columnMask)
+{
+    return sizeof(uint64_t) + columnCount(columnMask) * sizeof(float);
+}
+
+SpillFiles::SpillFiles(const std::string &dir)
+    : m_dir(dir)
+{
+    if (m_dir.empty()) {
+        std::error_code ec;
+        m_dir = std::filesystem::temp_directory_path(ec).string();
+        if (ec) {
+            m_dir = ".";
+        }
+    }
+}
+
+SpillFiles::~SpillFiles()
+{
+    for (const std::string &path : m_paths) {
+        std::remove(path.c_str());
+    }
+}
+
+std::string SpillFiles::next()
+{
+    // 时间 + 进程内计数 + 对象地址，足以在同一目录下避免冲突
+    static std::atomic<unsigned> counter(0);
+    unsigned long long tick = (unsigned long long)
+        std::chrono::steady_clock::now().time_since_epoch().count();
+    char name[96];
+    std::snprintf(name, sizeof(name), "bint-%llx-%p-%u.run", tick, (void *)this, counter++);
+    std::filesystem::path path = std::filesystem::path(m_dir) / name;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_paths.push_back(path.string());
+    return m_paths.back();
+}
+
+bool SpillFiles::owns(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::find(m_paths.begin(), m_paths.end(), path) != m_paths.end();
+}
+
+RunWriter::RunWriter(const std::string &path, uint32_t columnMask)
+    : m_path(path)
+    , m_columnMask(columnMask)
+    , m_rowBytes(runRowBytes(columnMask))
+{
+    m_fp = std::fopen(path.c_str(), "wb");
+    if (!m_fp) {
+        throw std::runtime_error("无法创建临时文件：" + path);
+    }
+    m_buffer.resize(kRunBufferRows * m_rowBytes);
+    std::memcpy(m_buffer.data(), kRunMagic, sizeof(kRunMagic));
+    std::memcpy(m_buffer.data() + sizeof(kRunMagic), &m_columnMask, sizeof(m_columnMask));
+    m_used = kRunHeaderBytes;
+}
+
+RunWriter::~RunWriter()
+{
+    if (m_fp) {
+        std::fclose(m_fp);
+    }
+}
+
+void RunWriter::write(uint64_t ts, const float *values)
+{
+    if (m_used + m_rowBytes > m_buffer.size()) {
+        flush();
+    }
+    unsigned char *p = m_buffer.data() + m_used;
+    std::memcpy(p, &ts, sizeof(ts));
+    std::memcpy(p + sizeof(ts), values, m_rowBytes - sizeof(ts));
+    m_used += m_rowBytes;
+    ++m_rows;
+}
+
+void RunWriter::write(const RecordTable &table, const std::vector<uint32_t> &order)
+{
+    size_t count = table.size();
+    if (count > 0 && table.columnMask != m_columnMask) {
+        throw std::runtime_error("有序段与表保存的列不同：" + m_path);
+    }
+    for (size_t k = 0; k < count; ++k) {
+        size_t i = order.empty() ? k : order[k];
+        float values[kChannelCount];
+        table.gatherRow(i, values);
+        write(table.timestamps[i], values);
+    }
+}
+
+void RunWriter::flush()
+{
+    PerfTimer timer(PerfStage::Write);
+    if (m_used > 0 && std::fwrite(m_buffer.data(), 1, m_used, m_fp) != m_used) {
+        throw std::runtime_error("写临时文件失败：" + m_path);
+    }
+    m_used = 0;
+}
+
+void RunWriter::close()
+{
+    if (!m_fp) {
+        return;
+    }
+    flush();
+    FILE *fp = m_fp;
+    m_fp = nullptr;
+    if (std::fclose(fp) != 0) {
+        throw std::runtime_error("写临时文件失败：" + m_path);
+    }
+}
+
+RunReader::RunReader(const std::string &path)
+    : m_path(path)
+{
+    m_fp = std::fopen(path.c_str(), "rb");
+    if (!m_fp) {
+        throw std::runtime_error("无法打开临时文件：" + path);
+    }
+    unsigned char header[kRunHeaderBytes];
+    if (std::fread(header, 1, sizeof(header), m_fp) != sizeof(header) ||
+        std::memcmp(header, kRunMagic, sizeof(kRunMagic)) != 0) {
+        std::fclose(m_fp);
+        m_fp = nullptr;
+        throw std::runtime_error("临时文件格式不对：" + path);
+    }
+    std::memcpy(&m_columnMask, header + sizeof(kRunMagic), sizeof(m_columnMask));
+    m_columnMask &= kAllColumns;
+    m_rowBytes = runRowBytes(m_columnMask);
+    m_buffer.resize(kRunBufferRows * m_rowBytes);
+}
+
+RunReader::~RunReader()
+{
+    if (m_fp) {
+        std::fclose(m_fp);
+    }
+}
+
+bool RunReader::next()
+{
+    if (m_pos + m_rowBytes > m_size) {
+        PerfTimer timer(PerfStage::Read);
+        m_size = std::fread(m_buffer.data(), 1, m_buffer.size(), m_fp);
+        m_pos = 0;
+        if (m_size < m_rowBytes) {
+            if (std::ferror(m_fp)) {
+                throw std::runtime_error("读临时文件失败：" + m_path);
+            }
+            return false;
+        }
+    }
+    const unsigned char *p = m_buffer.data() + m_pos;
+    std::memcpy(&m_ts, p, sizeof(m_ts));
+    std::memcpy(m_values, p + sizeof(m_ts), m_rowBytes - sizeof(m_ts));
+    m_pos += m_rowBytes;
+    return true;
+}
+
+typedef std::vector<std::unique_ptr<RunReader>> RunReaders;
+
+// 打开 runPaths 的各段，返回共同的列掩码；各段的列不同时抛出 std::runtime_error
+static uint32_t openRuns(const std::vector<std::string> &runPaths, RunReaders &readers)
+{
+    readers.reserve(runPaths.size());
+    for (const std::string &path : runPaths) {
+        readers.emplace_back(new RunReader(path));
+        if (readers.back()->columnMask() != readers.front()->columnMask()) {
+            throw std::runtime_error("有序段保存的列不一致：" + path);
+        }
+    }
+    return readers.empty() ? kAllColumns : readers.front()->columnMask();
+}
+
+// k 路归并已打开的各段，去重后的每行调用 writeRow(时间戳, 各列的值)，返回行数
+template <typename RowWriter>
+static uint64_t mergeRunsInto(RunReaders &readers, RowWriter &&writeRow)
+{
+    typedef std::pair<uint64_t, size_t> HeapItem;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+    for (size_t r = 0; r < readers.size(); ++r) {
+        if (readers[r]->next()) {
+            heap.push(HeapItem(readers[r]->timestamp(), r));
+        }
+    }
+
+    uint64_t written = 0;
+    bool first = true;
+    uint64_t last = 0;
+    while (!heap.empty()) {
+        HeapItem top = heap.top();
+        heap.pop();
+        RunReader &reader = *readers[top.second];
+        if (first || top.first != last) {
+            writeRow(top.first, reader.values());
+            ++written;
+            first = false;
+            last = top.first;
+        }
+        if (reader.next()) {
+            heap.push(HeapItem(reader.timestamp(), top.second));
+        }
+    }
+    return written;
+}
+
+uint64_t mergeRuns(const std::vector<std::string> &runPaths, RecordSink &sink)
+{
+    PerfTimer timer(PerfStage::Format);
+    RunReaders readers;
+    size_t columns = columnCount(openRuns(runPaths, readers));
+    return mergeRunsInto(readers, [&](uint64_t ts, const float *values){
+        sink.writeRow(ts, values, columns);
+    });
+}
+
+void reduceRuns(std::vector<std::string> &runPaths, SpillFiles &spill, size_t maxWays)
+{
+    PerfTimer timer(PerfStage::SortDedup);
+    if (maxWays < 2) {
+        maxWays = 2;
+    }
+    while (runPaths.size() > maxWays) {
+        // 相邻的段合成一组，组间顺序不变，时间戳相同时仍是先出现的段优先
+        std::vector<std::string> merged;
+        for (size_t first = 0; first < runPaths.size(); first += maxWays) {
+            size_t end = std::min(first + maxWays, runPaths.size());
+            if (end - first == 1) {
+                merged.push_back(runPaths[first]);
+                continue;
+            }
+            std::vector<std::string> group(runPaths.begin() + first, runPaths.begin() + end);
+            RunReaders readers;
+            uint32_t columnMask = openRuns(group, readers);
+            merged.push_back(spill.next());
+            RunWriter out(merged.back(), columnMask);
+            mergeRunsInto(readers, [&](uint64_t ts, const float *values){
+                out.write(ts, values);
+            });
+            out.close();
+            readers.clear();
+            for (const std::string &path : group) {
+                if (spill.owns(path)) {
+                    std::remove(path.c_str());
+                }
+            }
+        }
+        runPaths.swap(merged);
+    }
+}
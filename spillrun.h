@@ -0,0 +1,128 @@
+#ifndef SPILLRUN_H
+#define SPILLRUN_H
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "recordtable.h"
+
+class RecordSink;
+
+/// 一次归并同时打开的段数上限；每段一个读缓冲（约 240KB），也受打开文件数限制
+static const size_t kMaxMergeWays = 64;
+
+/**
+ * @brief SpillFiles
+ *  一组临时文件，析构时全部删除。dir 为空时使用系统临时目录。
+ *  可在多个线程中同时取新路径。
+ */
+class SpillFiles
+{
+public:
+    explicit SpillFiles(const std::string &dir = std::string());
+    ~SpillFiles();
+
+    SpillFiles(const SpillFiles &) = delete;
+    SpillFiles &operator=(const SpillFiles &) = delete;
+
+    /// 生成一个新的临时文件路径（尚未创建）
+    std::string next();
+    /// path 是否为本组的临时文件
+    bool owns(const std::string &path);
+
+private:
+    std::string m_dir;
+    std::mutex m_mutex;
+    std::vector<std::string> m_paths;
+};
+
+/**
+ * @brief RunWriter
+ *  将已排序的行以紧凑二进制写入临时文件，作为外部排序的一个有序段。
+ *  文件头为格式标记与列掩码，之后每行为 uint64 时间戳 + columnMask 中各列的 float
+ *  （本机字节序，仅供本机读回）；按列投影时未选中的列不落盘。
+ *  打开或写入失败抛出 std::runtime_error。
+ */
+class RunWriter
+{
+public:
+    explicit RunWriter(const std::string &path, uint32_t columnMask = kAllColumns);
+    ~RunWriter();
+
+    RunWriter(const RunWriter &) = delete;
+    RunWriter &operator=(const RunWriter &) = delete;
+
+    /// 写一行，values 为 columnMask 中各列的值（按列顺序）
+    void write(uint64_t ts, const float *values);
+    /// 按 order 顺序写出 table 的全部行（order 为空时按原顺序），各行为保存的列（同 gatherRow）；
+    /// table 保存的列须与 columnMask 相同
+    void write(const RecordTable &table, const std::vector<uint32_t> &order);
+    void close();
+
+    uint64_t rows() const { return m_rows; }
+
+private:
+    void flush();
+
+    std::string m_path;
+    FILE *m_fp = nullptr;
+    uint32_t m_columnMask;
+    size_t m_rowBytes;
+    std::vector<unsigned char> m_buffer;
+    size_t m_used = 0;
+    uint64_t m_rows = 0;
+};
+
+/**
+ * @brief RunReader
+ *  顺序读回 RunWriter 写出的有序段。格式不对时抛出 std::runtime_error。
+ */
+class RunReader
+{
+public:
+    explicit RunReader(const std::string &path);
+    ~RunReader();
+
+    RunReader(const RunReader &) = delete;
+    RunReader &operator=(const RunReader &) = delete;
+
+    /// 读到下一行返回 true，已读完返回 false
+    bool next();
+    uint64_t timestamp() const { return m_ts; }
+    /// 当前行的值，为 columnMask() 中各列（按列顺序）
+    const float *values() const { return m_values; }
+    uint32_t columnMask() const { return m_columnMask; }
+
+private:
+    std::string m_path;
+    FILE *m_fp = nullptr;
+    uint32_t m_columnMask = kAllColumns;
+    size_t m_rowBytes = 0;
+    std::vector<unsigned char> m_buffer;
+    size_t m_pos = 0;
+    size_t m_size = 0;
+    uint64_t m_ts = 0;
+    float m_values[kChannelCount];
+};
+
+/**
+ * @brief mergeRuns
+ *  k 路归并多个有序段写入 sink（不含表头）。时间戳相同时先出现的段优先，
+ *  且只保留第一条，结果与按段顺序拼接后稳定排序去重相同。
+ *  各段保存的列须相同，每行向 sink 写出这些列的值。返回写出的行数。
+ */
+uint64_t mergeRuns(const std::vector<std::string> &runPaths, RecordSink &sink);
+
+/**
+ * @brief reduceRuns
+ *  段数超过 maxWays 时，把相邻的每 maxWays 个段归并（同样去重）为 spill 中的一个新段，
+ *  重复到段数不超过 maxWays；已归并的 spill 中的段随即删除，其他段（如缓存的段）保留。
+ *  之后再 mergeRuns 的结果不变。
+ */
+void reduceRuns(std::vector<std::string> &runPaths, SpillFiles &spill,
+                size_t maxWays = kMaxMergeWays);
+
+#endif // SPILLRUN_H
@@ -0,0 +1,344 @@
+#include "streampipeline.h"
+#include "inputsource.h"
+#include "parsebin.h"
+#include "spillrun.h"
+#include "perfstats.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+static inline bool isCancelled(const StreamOptions &options)
+{
+    return options.cancel && options.cancel->load(std::memory_order_relaxed);
+}
+
+static inline RecordQuery queryOf(const StreamOptions &options)
+{
+    return options.query ? *options.query : RecordQuery();
+}
+
+static std::unique_ptr<RecordSink> openSink(const std::string &filename, const StreamOptions &options)
+{
+    return openRecordSink(filename, options.format, options.encoding, queryOf(options).columnMask,
+                          options.aggregation);
+}
+
+/**
+ * 有界环形批次队列：固定数量的 RecordTable 在空闲队列与待写队列之间循环，
+ * 解析线程取空闲批次填满后放入待写队列，写出线程取出写完后归还。
+ * 给出 pool 时批次从池中取出，队列销毁时归还。
+ */
+class BatchRing
+{
+public:
+    BatchRing(size_t depth, RecyclePool<RecordTable> *pool)
+        : m_slots(depth < 2 ? 2 : depth)
+        , m_pool(pool)
+    {
+        for (RecordTable &t : m_slots) {
+            if (m_pool) {
+                t = m_pool->acquire();
+            }
+            m_free.push_back(&t);
+        }
+    }
+
+    ~BatchRing()
+    {
+        if (m_pool) {
+            for (RecordTable &t : m_slots) {
+                m_pool->release(std::move(t));
+            }
+        }
+    }
+
+    /// 取一个空闲批次，队列已停止时返回 nullptr
+    RecordTable *acquire()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]{ return m_stopped || !m_free.empty(); });
+        if (m_stopped) {
+            return nullptr;
+        }
+        RecordTable *t = m_free.front();
+        m_free.pop_front();
+        return t;
+    }
+
+    /// 放入一个待写批次，nullptr 表示输入结束
+    void push(RecordTable *t)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_full.push_back(t);
+        m_changed.notify_all();
+    }
+
+    /// 取下一个待写批次，输入结束或已停止时返回 nullptr
+    RecordTable *pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this]{ return m_stopped || !m_full.empty(); });
+        if (m_full.empty()) {
+            return nullptr;
+        }
+        RecordTable *t = m_full.front();
+        m_full.pop_front();
+        return t;
+    }
+
+    void release(RecordTable *t)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free.push_back(t);
+        m_changed.notify_all();
+    }
+
+    /// 让两端尽快退出
+    void stop()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+        m_changed.notify_all();
+    }
+
+private:
+    std::vector<RecordTable> m_slots;
+    RecyclePool<RecordTable> *m_pool;
+    std::deque<RecordTable *> m_free;
+    std::deque<RecordTable *> m_full;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_stopped = false;
+};
+
+// 依次解析所有文件，每批回调 onBatch(table)；onBatch 返回 false 时停止
+template <typename BatchFn>
+static void decodeAll(const std::vector<std::string> &binPaths, const StreamOptions &options,
+                      BatchFn &&onBatch)
+{
+    RecordLayout layout = options.layout ? *options.layout : RecordLayout();
+    RecordQuery query = queryOf(options);
+    for (const std::string &path : binPaths) {
+        BinBlockReader reader(path, layout, query);
+        if (options.progress) {
+            // 文件头与时间范围外未读取的块计入进度
+            options.progress(reader.dataOffset() + reader.skippedBytes(), 0);
+        }
+        while (true) {
+            if (isCancelled(options)) {
+                throw ParseCancelled();
+            }
+            bool more = true;
+            if (!onBatch(reader, more)) {
+                return;
+            }
+            if (!more) {
+                break;
+            }
+        }
+    }
+}
+
+// 直接流式写出；时间戳回退时返回 false（输出不完整，由调用方改走外部排序）
+static bool streamMonotonic(const std::vector<std::string> &binPaths,
+                            const std::string &csvFilename,
+                            const StreamOptions &options, StreamStats &stats)
+{
+    BatchRing ring(options.queueDepth, options.tablePool);
+    std::exception_ptr producerError;
+
+    std::thread producer([&]{
+        try {
+            decodeAll(binPaths, options, [&](BinBlockReader &reader, bool &more){
+                RecordTable *t = ring.acquire();
+                if (!t) {
+                    return false; // 写出端已停止
+                }
+                t->clear();
+                size_t blocks = reader.decodeNext(*t, options.batchBlocks);
+                more = blocks > 0;
+                if (options.progress) {
+                    options.progress(blocks * reader.blockSize(), t->size());
+                }
+                if (t->empty()) {
+                    ring.release(t);
+                } else {
+                    ring.push(t);
+                }
+                return true;
+            });
+        } catch (...) {
+            producerError = std::current_exception();
+        }
+        ring.push(nullptr);
+    });
+
+    bool monotonic = true;
+    try {
+        std::unique_ptr<RecordSink> sink = openSink(csvFilename, options);
+        sink->writeHeader();
+
+        bool first = true;
+        uint64_t last = 0;
+        while (RecordTable *t = ring.pop()) {
+            PerfTimer timer(PerfStage::Format);
+            const std::vector<uint64_t> &ts = t->timestamps;
+            for (size_t i = 0; i < ts.size() && monotonic; ++i) {
+                if (!first && ts[i] <= last) {
+                    // 相同时间戳只保留第一条；更早的时间戳说明输入无序
+                    monotonic = (ts[i] == last);
+                    continue;
+                }
+                float values[kChannelCount];
+                size_t count = t->gatherRow(i, values);
+                sink->writeRow(ts[i], values, count);
+                ++stats.rowsWritten;
+                first = false;
+                last = ts[i];
+            }
+            ring.release(t);
+            if (!monotonic) {
+                break;
+            }
+        }
+        ring.stop();
+        producer.join();
+
+        if (producerError) {
+            std::rethrow_exception(producerError);
+        }
+        // 输入无序时丢弃已写的部分，由外部排序重新写出
+        if (monotonic) {
+            sink->close();
+        }
+    } catch (...) {
+        ring.stop();
+        if (producer.joinable()) {
+            producer.join();
+        }
+        throw;
+    }
+    return monotonic;
+}
+
+// 外部排序：分段解析、段内稳定排序后落盘，最后 k 路归并写出
+static void externalSort(const std::vector<std::string> &binPaths,
+                         const std::string &csvFilename,
+                         const StreamOptions &options, StreamStats &stats)
+{
+    SpillFiles spill(options.tempDir);
+    std::vector<std::string> runs;
+    Recycled<RecordTable> pooled(options.tablePool);
+    RecordTable &table = *pooled;
+    std::vector<uint32_t> order;
+
+    auto spillTable = [&]{
+        PerfTimer timer(PerfStage::Format);
+        sortRowOrder(table.timestamps.data(), table.size(), order);
+        runs.push_back(spill.next());
+        RunWriter run(runs.back(), queryOf(options).columnMask);
+        run.write(table, order);
+        run.close();
+        table.clear();
+    };
+
+    decodeAll(binPaths, options, [&](BinBlockReader &reader, bool &more){
+        size_t before = table.size();
+        size_t blocks = reader.decodeNext(table, options.batchBlocks);
+        more = blocks > 0;
+        if (options.progress) {
+            options.progress(blocks * reader.blockSize(), table.size() - before);
+        }
+        if (table.size() >= options.sortRunRows) {
+            spillTable();
+        }
+        return true;
+    });
+
+    std::unique_ptr<RecordSink> sink = openSink(csvFilename, options);
+    sink->writeHeader();
+    if (runs.empty()) {
+        // 全部数据不超过一个段，直接排序写出，无需落盘
+        PerfTimer timer(PerfStage::Format);
+        bool sorted = !sortRowOrder(table.timestamps.data(), table.size(), order);
+        const std::vector<uint64_t> &ts = table.timestamps;
+        size_t prev = 0;
+        for (size_t k = 0; k < table.size(); ++k) {
+            size_t i = sorted ? k : order[k];
+            if (k > 0 && ts[i] == ts[prev]) {
+                continue;
+            }
+            float values[kChannelCount];
+            size_t count = table.gatherRow(i, values);
+            sink->writeRow(ts[i], values, count);
+            ++stats.rowsWritten;
+            prev = i;
+        }
+        sink->close();
+        return;
+    }
+    if (!table.empty()) {
+        spillTable();
+    }
+    reduceRuns(runs, spill);
+    stats.rowsWritten = mergeRuns(runs, *sink);
+    sink->close();
+}
+
+StreamStats streamBinToCsv(const std::vector<std::string> &binPaths,
+                           const std::string &csvFilename,
+                           const StreamOptions &options)
+{
+    // 记录第一遍已上报的进度，外部排序重新解析时只上报超出的部分
+    uint64_t reportedBytes = 0;
+    uint64_t reportedRows = 0;
+    StreamOptions first = options;
+    if (options.progress) {
+        first.progress = [&](uint64_t bytes, uint64_t rows){
+            reportedBytes += bytes;
+            reportedRows += rows;
+            options.progress(bytes, rows);
+        };
+    }
+
+    // 标准输入只能读一遍，无法在时间戳回退后重新解析：直接走只读一遍的外部排序，
+    // 有序输入的段内排序只是一次检查，数据不超过一个段时也不落盘
+    StreamStats stats;
+    bool rereadable = std::none_of(binPaths.begin(), binPaths.end(), [](const std::string &path){
+        return inputKindForPath(path) == InputKind::Stdin;
+    });
+    if (!rereadable) {
+        stats.externalSort = true;
+        externalSort(binPaths, csvFilename, options, stats);
+        return stats;
+    }
+
+    // 输出端未 close() 时自行丢弃临时文件，失败不会留下不完整的输出
+    if (!streamMonotonic(binPaths, csvFilename, first, stats)) {
+        StreamOptions second = options;
+        if (options.progress) {
+            uint64_t bytesSeen = 0;
+            uint64_t rowsSeen = 0;
+            second.progress = [&, bytesSeen, rowsSeen](uint64_t bytes, uint64_t rows) mutable {
+                uint64_t b = bytesSeen + bytes > reportedBytes ? bytesSeen + bytes - reportedBytes : 0;
+                uint64_t r = rowsSeen + rows > reportedRows ? rowsSeen + rows - reportedRows : 0;
+                bytesSeen += bytes;
+                rowsSeen += rows;
+                reportedBytes += b;
+                reportedRows += r;
+                if (b || r) {
+                    options.progress(b, r);
+                }
+            };
+        }
+        stats = StreamStats();
+        stats.externalSort = true;
+        externalSort(binPaths, csvFilename, second, stats);
+    }
+    return stats;
+}
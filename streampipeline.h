@@ -0,0 +1,62 @@
+#ifndef STREAMPIPELINE_H
+#define STREAMPIPELINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "csvwriter.h"
+#include "recordsink.h"
+#include "aggregatesink.h"
+#include "recordlayout.h"
+#include "recordquery.h"
+#include "recordtable.h"
+#include "recyclepool.h"
+
+/// 流式转换选项
+struct StreamOptions {
+    size_t batchBlocks = 16384;         ///< 每批解析的块数（2MB 输入，最多 32K 行）
+    size_t queueDepth = 4;              ///< 解析与写出之间的环形批次数
+    size_t sortRunRows = 1 << 20;       ///< 外部排序时每个有序段的行数（约 60MB）
+    std::string tempDir;                ///< 外部排序临时目录，空为系统临时目录
+    OutputFormat format = OutputFormat::Csv;
+    CsvEncoding encoding = CsvEncoding::Native;    ///< 仅 CSV 输出有效
+    /// 进度回调：新消耗的输入字节数与新解析的行数
+    std::function<void(uint64_t bytes, uint64_t rows)> progress;
+    /// 取消标志：置为 true 后尽快停止并抛出 ParseCancelled，不留下输出文件
+    const std::atomic<bool> *cancel = nullptr;
+    /// 记录布局，空为默认布局
+    const RecordLayout *layout = nullptr;
+    /// 时间范围与列投影，空为全部行、全部列
+    const RecordQuery *query = nullptr;
+    /// 按时间窗口聚合输出，空为逐行输出
+    const Aggregation *aggregation = nullptr;
+    /// 非空时批次与外部排序段的记录表从该池取出、用完归还，多次转换之间复用
+    RecyclePool<RecordTable> *tablePool = nullptr;
+};
+
+/// 流式转换结果
+struct StreamStats {
+    uint64_t rowsWritten = 0;
+    bool externalSort = false;          ///< 是否走了外部排序（时间戳回退或输入为标准输入）
+};
+
+/**
+ * @brief streamBinToCsv
+ *  按顺序流式解析一个或多个 bin 文件并写入一个 CSV（或 options.format 指定的格式），
+ *  内存占用与输入大小无关：
+ *  解析线程把块解码成批放入有界环形队列，调用线程同时格式化写出，
+ *  按时间戳增量去重（相同时间戳只保留第一条）。
+ *  一旦发现时间戳回退，改为外部排序：重新解析并按 sortRunRows 分段排序落盘，
+ *  再 k 路归并写出。结果与 writeRecords 完全相同。
+ *  输入含标准输入（"-"）时无法重读，直接走外部排序，只读一遍。
+ *  失败抛出 std::runtime_error，取消抛出 ParseCancelled，两种情况下都不留下输出文件（已有的同名文件保持不变）。
+ */
+StreamStats streamBinToCsv(const std::vector<std::string> &binPaths,
+                           const std::string &csvFilename,
+                           const StreamOptions &options = StreamOptions());
+
+#endif // STREAMPIPELINE_H
@@ -0,0 +1,111 @@
+#include "threadpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0) threadCount = 1;
+    }
+    m_workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskReady.notify_all();
+    for (auto &t : m_workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_allDone.wait(lock, [this]{ return m_tasks.empty() && m_active == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &fn)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // 共享的下标计数器：调用线程与池内线程各自领取下标，领完即止
+    struct State {
+        std::atomic<size_t> next{0};
+        size_t remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+    auto state = std::make_shared<State>();
+    state->remaining = count;
+
+    auto run = [state, count, &fn]{
+        size_t finished = 0;
+        for (size_t i; (i = state->next.fetch_add(1)) < count; ++finished) {
+            fn(i);
+        }
+        if (finished > 0) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->remaining -= finished;
+            if (state->remaining == 0) {
+                state->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(count - 1, m_workers.size());
+    for (size_t h = 0; h < helpers; ++h) {
+        submit(run);
+    }
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&]{ return state->remaining == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskReady.wait(lock, [this]{ return m_stopping || !m_tasks.empty(); });
+            if (m_tasks.empty()) {
+                return; // m_stopping
+            }
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+            ++m_active;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+            if (m_tasks.empty() && m_active == 0) {
+                m_allDone.notify_all();
+            }
+        }
+    }
+}
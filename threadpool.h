@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief ThreadPool
+ *  固定大小的工作线程池。任务不应抛出异常（需要时在任务内部捕获并记录）。
+ */
+class ThreadPool
+{
+public:
+    /// threadCount 为0时按硬件线程数
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    unsigned size() const { return (unsigned)m_workers.size(); }
+
+    void submit(std::function<void()> task);
+    /// 等待所有已提交的任务执行完毕
+    void wait();
+
+    /**
+     * 对 0..count-1 并行调用 fn(i)，返回时全部完成。调用线程自身也参与执行，
+     * 因此可以在池内任务中嵌套调用而不会死锁。fn 不应抛出异常。
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+private:
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_taskReady;
+    std::condition_variable m_allDone;
+    size_t m_active = 0;
+    bool m_stopping = false;
+};
+
+#endif // THREADPOOL_H